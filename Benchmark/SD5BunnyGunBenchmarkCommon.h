@@ -0,0 +1,215 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+#include "SD5BunnyGunMovementMath.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/**
+ * Shared workload & reporting helpers for the standalone movement benchmarks.
+ */
+namespace SD5BunnyGunBenchmark
+{
+	// Minimal stand-in for FVector.
+	struct FBenchVector
+	{
+		float X;
+		float Y;
+		float Z;
+
+		FBenchVector() : X(0.0f), Y(0.0f), Z(0.0f) { }
+		FBenchVector(float InX, float InY, float InZ) : X(InX), Y(InY), Z(InZ) { }
+	};
+
+	// Default tuning values of USD5BunnyGunCharacterMovement.
+	struct FBenchTuning
+	{
+		float GroundFriction;
+		float StopSpeed;
+		float MaxWalkSpeed;
+		float MaxAcceleration;
+		float MaxFallAirSpeed;
+		float MaxAirAcceleration;
+		float EnforcedMaxSpeed;
+		SD5BunnyGunMovementMath::FTrimpingParams Trimping;
+		SD5BunnyGunMovementMath::FStaminaParams Stamina;
+
+		FBenchTuning()
+		{
+			GroundFriction = 5.0f;
+			StopSpeed = 150.0f;
+			MaxWalkSpeed = 700.0f;
+			MaxAcceleration = 6.0f;
+			MaxFallAirSpeed = 100.0f;
+			MaxAirAcceleration = 20.0f;
+			EnforcedMaxSpeed = 3500.0f;
+
+			Trimping.JumpZVelocity = 380.0f;
+			Trimping.MaxTrimpJumpHeightReductionMultiplier = 0.375f;
+			Trimping.MaxTrimpVerticalVelocityBoost = 2000.0f;
+			Trimping.TrimpVerticalVelocityBoostMultiplier = 1.25f;
+			Trimping.MaxTrimpHorizSpeedBoost = 1000.0f;
+			Trimping.TrimpHorizSpeedBoostMultiplier = 2.75f;
+
+			Stamina.MaxStamina = 100.0f;
+			Stamina.StaminaJumpCost = 25.0f;
+			Stamina.StaminaRecoveryRate = 20.0f;
+		}
+	};
+
+	// Per-character state of a simulated bunnyhopper.
+	struct FBenchCharacter
+	{
+		FBenchVector Velocity;
+		FBenchVector WishDirection;
+		FBenchVector FloorNormal;
+		float Stamina;
+		uint32_t Tick;
+	};
+
+	// Fixed timestep used by every benchmark (60 Hz).
+	const float BenchDeltaTime = 1.0f / 60.0f;
+
+	// Number of ticks a simulated character spends in the air between hops.
+	const uint32_t BenchAirTicks = 40;
+
+	// Character counts every benchmark is run at.
+	const size_t BenchCharacterCounts[] = { 1, 1000, 100000 };
+
+	// Rough number of updates timed per run, so small runs are not dominated by timer noise.
+	const uint64_t BenchTargetUpdates = 4000000;
+
+	// Deterministic LCG so that every run simulates the exact same workload.
+	inline float BenchRandom(uint32_t& Seed)
+	{
+		Seed = Seed * 1664525u + 1013904223u;
+		return static_cast<float>(Seed >> 8) / 16777216.0f;
+	}
+
+	// Creates NumCharacters characters moving in random directions at random speeds, over random slopes.
+	inline std::vector<FBenchCharacter> MakeBenchCharacters(size_t NumCharacters)
+	{
+		std::vector<FBenchCharacter> Characters(NumCharacters);
+
+		auto Seed = 0x5D5u;
+		for (auto& Character : Characters)
+		{
+			const auto Yaw = BenchRandom(Seed) * 2.0f * SD5BunnyGunMovementMath::Pi;
+			const auto Speed = 200.0f + BenchRandom(Seed) * 1500.0f;
+			Character.Velocity = FBenchVector(std::cos(Yaw) * Speed, std::sin(Yaw) * Speed, 0.0f);
+			Character.WishDirection = FBenchVector(-std::sin(Yaw), std::cos(Yaw), 0.0f);
+
+			const auto SlopeYaw = BenchRandom(Seed) * 2.0f * SD5BunnyGunMovementMath::Pi;
+			const auto SlopeSin = BenchRandom(Seed) * 0.7f;
+			const auto SlopeCos = std::sqrt(1.0f - SlopeSin * SlopeSin);
+			Character.FloorNormal = FBenchVector(std::cos(SlopeYaw) * SlopeSin, std::sin(SlopeYaw) * SlopeSin, SlopeCos);
+
+			Character.Stamina = 0.0f;
+			Character.Tick = static_cast<uint32_t>(BenchRandom(Seed) * BenchAirTicks);
+		}
+
+		return Characters;
+	}
+
+	// Returns whether or not the character is on the ground this tick (they land for a single tick between hops).
+	inline bool IsBenchCharacterOnGround(const FBenchCharacter& Character)
+	{
+		return (Character.Tick % BenchAirTicks) == 0;
+	}
+
+	// Turns the wish direction of the character slightly, like a player strafing with the mouse.
+	inline void TurnBenchCharacter(FBenchCharacter& Character)
+	{
+		// cos & sin of 2 degrees.
+		const auto TurnCos = 0.99939083f;
+		const auto TurnSin = 0.03489950f;
+		const auto Wish = Character.WishDirection;
+		Character.WishDirection.X = Wish.X * TurnCos - Wish.Y * TurnSin;
+		Character.WishDirection.Y = Wish.X * TurnSin + Wish.Y * TurnCos;
+	}
+
+	// One tick of the custom velocity phase of USD5BunnyGunCharacterMovement::CalcVelocity() & DoJump() for a character.
+	template <typename MathPolicy = SD5BunnyGunMovementMath::FMovementMathPolicy>
+	inline void UpdateBenchCharacter(FBenchCharacter& Character, const FBenchTuning& Tuning)
+	{
+		namespace Math = SD5BunnyGunMovementMath;
+
+		const auto DeltaTime = BenchDeltaTime;
+		if (IsBenchCharacterOnGround(Character))
+		{
+			const auto WalkMultiplier = Math::GetStaminaWalkSpeedMultiplier<MathPolicy>(Character.Stamina, DeltaTime, Tuning.Stamina);
+			Character.Velocity.X *= WalkMultiplier;
+			Character.Velocity.Y *= WalkMultiplier;
+
+			Math::ApplyFriction<MathPolicy>(Character.Velocity, DeltaTime, Tuning.GroundFriction, 1.0f, Tuning.StopSpeed);
+			Math::ApplyAcceleration(Character.Velocity, DeltaTime, 1.0f, Character.WishDirection, Tuning.MaxWalkSpeed, Tuning.MaxAcceleration);
+
+			// Jump straight away again.
+			Character.Velocity.Z = Tuning.Trimping.JumpZVelocity;
+			Math::ApplyTrimpingVelocity<MathPolicy>(Character.Velocity, Character.FloorNormal, Tuning.Trimping);
+			Character.Velocity.Z *= Math::GetStaminaJumpVelocityMultiplier(Character.Stamina, Tuning.Stamina);
+			Character.Stamina = Math::GetStaminaAfterJump(Tuning.Stamina);
+		}
+		else
+		{
+			Math::ApplyAirAcceleration(Character.Velocity, DeltaTime, 1.0f, Character.WishDirection, Tuning.MaxWalkSpeed, Tuning.MaxFallAirSpeed, Tuning.MaxAirAcceleration);
+		}
+
+		Character.Velocity = Math::GetClampedToMaxSizePrecise(Character.Velocity, Tuning.EnforcedMaxSpeed);
+		Character.Stamina = Math::DecayStamina(Character.Stamina, DeltaTime);
+
+		TurnBenchCharacter(Character);
+		++Character.Tick;
+	}
+
+	// Number of ticks to run so that roughly BenchTargetUpdates updates are timed.
+	inline uint32_t GetBenchTicks(size_t NumCharacters)
+	{
+		const auto Ticks = BenchTargetUpdates / NumCharacters;
+		return static_cast<uint32_t>(Ticks > 0 ? Ticks : 1);
+	}
+
+	// Sums the speed of all characters so the compiler can't throw the simulation away.
+	inline double GetBenchChecksum(const std::vector<FBenchCharacter>& Characters)
+	{
+		auto Checksum = 0.0;
+		for (const auto& Character : Characters)
+		{
+			Checksum += std::sqrt(SD5BunnyGunMovementMath::SizeSquared(Character.Velocity));
+		}
+
+		return Checksum;
+	}
+
+	// Simple wall clock stopwatch.
+	class FBenchTimer
+	{
+	public:
+		FBenchTimer() : StartTime(std::chrono::steady_clock::now()) { }
+
+		double GetElapsedSeconds() const
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point StartTime;
+	};
+
+	inline void PrintBenchHeader(const char* Title)
+	{
+		std::printf("%s\n", Title);
+		std::printf("%-28s %12s %14s %16s %16s\n", "Path", "Characters", "Ticks", "ns/update", "updates/sec");
+	}
+
+	inline void PrintBenchResult(const char* Path, size_t NumCharacters, uint32_t Ticks, double Seconds)
+	{
+		const auto Updates = static_cast<double>(NumCharacters) * Ticks;
+		std::printf("%-28s %12zu %14u %16.2f %16.0f\n", Path, NumCharacters, Ticks, (Seconds * 1.e9) / Updates, Updates / Seconds);
+	}
+}
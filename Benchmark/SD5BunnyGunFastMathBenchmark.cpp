@@ -0,0 +1,173 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGunBenchmarkCommon.h"
+
+using namespace SD5BunnyGunBenchmark;
+using namespace SD5BunnyGunMovementMath;
+
+// Number of inputs sampled for every error sweep.
+static const int FastMathSamples = 1000000;
+
+// Number of calls timed per math function.
+static const int FastMathTimedCalls = 20000000;
+
+// Largest error found by a sweep, and the input it was found at.
+struct FFastMathError
+{
+	double MaxError;
+	double WorstInput;
+
+	FFastMathError() : MaxError(0.0), WorstInput(0.0) { }
+
+	void Add(double Error, double Input)
+	{
+		if (Error > MaxError)
+		{
+			MaxError = Error;
+			WorstInput = Input;
+		}
+	}
+};
+
+static double GetRelativeError(double Value, double Reference)
+{
+	return std::abs(Value - Reference) / std::max(std::abs(Reference), 1.e-30);
+}
+
+// Prints the result of a sweep, returning false if the error is over the documented bound.
+static bool PrintFastMathError(const char* Name, const FFastMathError& Error, float Bound)
+{
+	const auto bPassed = Error.MaxError <= Bound;
+	std::printf("%-28s %16.3e %16.3e %16g %s\n", Name, Error.MaxError, static_cast<double>(Bound), Error.WorstInput, (bPassed ? "ok" : "OVER BOUND"));
+	return bPassed;
+}
+
+// Number of inputs the timed calls cycle through (a power of 2).
+static const size_t FastMathTimedInputs = 4096;
+
+// Times FastMathTimedCalls calls of Function over Inputs, returning ns per call.
+template <typename FunctionType>
+static double TimeFastMathFunction(const std::vector<float>& Inputs, FunctionType Function)
+{
+	auto Sum = 0.0f;
+	const FBenchTimer Timer;
+	for (auto Call = 0; Call < FastMathTimedCalls; ++Call)
+	{
+		Sum += Function(Inputs[Call & (FastMathTimedInputs - 1)]);
+	}
+	const auto Seconds = Timer.GetElapsedSeconds();
+
+	// Keeps the compiler from throwing the calls away.
+	if (Sum == 12345.0f)
+	{
+		std::printf(" ");
+	}
+
+	return (Seconds * 1.e9) / FastMathTimedCalls;
+}
+
+// Runs the whole simulated velocity phase with a math policy, returning ns per update.
+template <typename MathPolicy>
+static double TimeFastMathUpdates(size_t NumCharacters, std::vector<FBenchCharacter>& OutCharacters)
+{
+	const FBenchTuning Tuning;
+	const auto Ticks = GetBenchTicks(NumCharacters);
+
+	OutCharacters = MakeBenchCharacters(NumCharacters);
+	const FBenchTimer Timer;
+	for (uint32_t Tick = 0; Tick < Ticks; ++Tick)
+	{
+		for (auto& Character : OutCharacters)
+		{
+			UpdateBenchCharacter<MathPolicy>(Character, Tuning);
+		}
+	}
+
+	return (Timer.GetElapsedSeconds() * 1.e9) / (static_cast<double>(NumCharacters) * Ticks);
+}
+
+// Measures the maximum error of FFastMathPolicy against FPreciseMathPolicy for the math functions and for the
+// movement functions that use them, then compares their speed. Fails if an error is over its documented bound.
+int main()
+{
+	const FBenchTuning Tuning;
+	auto bPassed = true;
+
+	std::printf("Fast math maximum error against precise math\n");
+	std::printf("%-28s %16s %16s %16s\n", "Function", "max error", "bound", "worst input");
+
+	// Relative error of inverse sqrt from 1e-6 to 1e8.
+	FFastMathError InvSqrtError;
+	for (auto Sample = 0; Sample < FastMathSamples; ++Sample)
+	{
+		const auto Value = static_cast<float>(std::pow(10.0, -6.0 + (14.0 * Sample) / FastMathSamples));
+		InvSqrtError.Add(GetRelativeError(FFastMathPolicy::InvSqrt(Value), FPreciseMathPolicy::InvSqrt(Value)), Value);
+	}
+	bPassed &= PrintFastMathError("InvSqrt (relative)", InvSqrtError, FastMathInvSqrtRelativeError);
+
+	// Absolute error of acos (radians) over its whole domain.
+	FFastMathError AcosError;
+	for (auto Sample = 0; Sample <= FastMathSamples; ++Sample)
+	{
+		const auto Value = -1.0f + (2.0f * Sample) / FastMathSamples;
+		AcosError.Add(std::abs(FFastMathPolicy::Acos(Value) - FPreciseMathPolicy::Acos(Value)), Value);
+	}
+	bPassed &= PrintFastMathError("Acos (radians)", AcosError, FastMathAcosError);
+
+	// Resulting error of the movement functions, in cm/s (not bounded, just reported).
+	FFastMathError TrimpError, FrictionError;
+	auto Characters = MakeBenchCharacters(FastMathSamples);
+	for (const auto& Character : Characters)
+	{
+		auto PreciseVelocity = Character.Velocity;
+		auto FastVelocity = Character.Velocity;
+		PreciseVelocity.Z = FastVelocity.Z = Tuning.Trimping.JumpZVelocity;
+		ApplyTrimpingVelocity<FPreciseMathPolicy>(PreciseVelocity, Character.FloorNormal, Tuning.Trimping);
+		ApplyTrimpingVelocity<FFastMathPolicy>(FastVelocity, Character.FloorNormal, Tuning.Trimping);
+		const auto TrimpDifference = FBenchVector(FastVelocity.X - PreciseVelocity.X, FastVelocity.Y - PreciseVelocity.Y, FastVelocity.Z - PreciseVelocity.Z);
+		TrimpError.Add(std::sqrt(SizeSquared(TrimpDifference)), std::sqrt(SizeSquared(Character.Velocity)));
+
+		PreciseVelocity = FastVelocity = Character.Velocity;
+		ApplyFriction<FPreciseMathPolicy>(PreciseVelocity, BenchDeltaTime, Tuning.GroundFriction, 1.0f, Tuning.StopSpeed);
+		ApplyFriction<FFastMathPolicy>(FastVelocity, BenchDeltaTime, Tuning.GroundFriction, 1.0f, Tuning.StopSpeed);
+		const auto FrictionDifference = FBenchVector(FastVelocity.X - PreciseVelocity.X, FastVelocity.Y - PreciseVelocity.Y, FastVelocity.Z - PreciseVelocity.Z);
+		FrictionError.Add(std::sqrt(SizeSquared(FrictionDifference)), std::sqrt(SizeSquared(Character.Velocity)));
+	}
+	std::printf("%-28s %16.3e %16s %16g\n", "ApplyTrimpingVelocity (cm/s)", TrimpError.MaxError, "-", TrimpError.WorstInput);
+	std::printf("%-28s %16.3e %16s %16g\n", "ApplyFriction (cm/s)", FrictionError.MaxError, "-", FrictionError.WorstInput);
+
+	// Speed of the math functions on their own.
+	std::vector<float> Values(FastMathTimedInputs), UnitValues(FastMathTimedInputs);
+	auto Seed = 0x5D5u;
+	for (size_t Index = 0; Index < Values.size(); ++Index)
+	{
+		Values[Index] = 1.0f + BenchRandom(Seed) * 4.e6f;
+		UnitValues[Index] = -1.0f + 2.0f * BenchRandom(Seed);
+	}
+
+	std::printf("\nFast math speed\n");
+	std::printf("%-28s %16s %16s %16s\n", "Function", "precise ns/call", "fast ns/call", "speedup");
+	const auto PrintSpeed = [](const char* Name, double PreciseNs, double FastNs)
+	{
+		std::printf("%-28s %16.2f %16.2f %15.2fx\n", Name, PreciseNs, FastNs, PreciseNs / FastNs);
+	};
+	PrintSpeed("InvSqrt", TimeFastMathFunction(Values, [](float V) { return FPreciseMathPolicy::InvSqrt(V); }),
+		TimeFastMathFunction(Values, [](float V) { return FFastMathPolicy::InvSqrt(V); }));
+	PrintSpeed("Acos", TimeFastMathFunction(UnitValues, [](float V) { return FPreciseMathPolicy::Acos(V); }),
+		TimeFastMathFunction(UnitValues, [](float V) { return FFastMathPolicy::Acos(V); }));
+
+	// Speed & drift of the whole simulated velocity phase.
+	std::printf("\nVelocity phase (ns/update)\n");
+	std::printf("%-28s %16s %16s %16s %16s\n", "Characters", "precise", "fast", "speedup", "checksum drift");
+	for (const auto NumCharacters : BenchCharacterCounts)
+	{
+		std::vector<FBenchCharacter> PreciseCharacters, FastCharacters;
+		const auto PreciseNs = TimeFastMathUpdates<FPreciseMathPolicy>(NumCharacters, PreciseCharacters);
+		const auto FastNs = TimeFastMathUpdates<FFastMathPolicy>(NumCharacters, FastCharacters);
+		std::printf("%-28zu %16.2f %16.2f %15.2fx %16.3e\n", NumCharacters, PreciseNs, FastNs, PreciseNs / FastNs,
+			GetRelativeError(GetBenchChecksum(FastCharacters), GetBenchChecksum(PreciseCharacters)));
+	}
+
+	std::printf("\nThis build uses the %s math policy.\n", FMovementMathPolicy::GetName());
+	return (bPassed ? 0 : 1);
+}
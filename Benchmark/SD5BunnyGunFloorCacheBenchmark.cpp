@@ -0,0 +1,260 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGunBenchmarkCommon.h"
+
+#include <unordered_map>
+
+using namespace SD5BunnyGunBenchmark;
+namespace Math = SD5BunnyGunMovementMath;
+
+// Character counts the floor cache is simulated at.
+static const size_t FloorCacheCharacterCounts[] = { 64, 256 };
+
+// Ticks simulated (a minute at 60 Hz).
+static const uint32_t FloorCacheTicks = 60 * 60;
+
+// The floor is a grid of flat static tiles (one primitive each), some of them raised into steps.
+static const float FloorTileSize = 500.0f;
+static const int32_t FloorTilesPerSide = 12;
+static const float FloorStepHeight = 20.0f;
+
+// Walkers query the floor every tick, bunnyhoppers only when they land (once every BenchAirTicks).
+static const float FloorWalkerFraction = 0.25f;
+static const float FloorWalkSpeed = 450.0f;
+
+// Floor distance of a walking capsule (between MIN_FLOOR_DIST & MAX_FLOOR_DIST), and how far it sweeps down.
+static const float FloorDistance = 2.15f;
+static const float FloorSweepDistance = 47.4f;
+
+// Mirrors FloorCacheMaxHeightOffset & the defaults of BunnyGun.FloorCacheMaxFloors.
+static const float FloorCacheMaxHeightOffset = 2.4f;
+static const size_t FloorCacheMaxFloors = 16384;
+
+// Size of the 3D cells of the old key (the old default of BunnyGun.FloorCacheCellSize).
+static const float FloorCacheOldCellSize = 2.0f;
+
+// 2D cell sizes of the new key that are compared, the first being the default of BunnyGun.FloorCacheCellSize.
+static const float FloorCacheCellSizes[] = { 32.0f, 16.0f, 64.0f };
+
+// The new key may give the wrong floor at most this often (per lookup) at the default cell size.
+static const double FloorCacheMaxWrongRate = 0.01;
+
+// Stand-in for FMath::FloorToInt().
+static int32_t FloorToInt(float Value)
+{
+	const auto Truncated = static_cast<int32_t>(Value);
+	return Truncated - (Value < static_cast<float>(Truncated) ? 1 : 0);
+}
+
+// A character moving over the tiles, and the floor it found on its last query.
+struct FFloorCacheCharacter
+{
+	FBenchVector Location;
+	FBenchVector Velocity;
+	bool bWalker;
+	uint32_t Tick;
+	float FloorHeight;
+	int32_t FloorTile;
+};
+
+// Mirrors FSD5BunnyGunFloorCacheKey (the capsule size & distances are the same for every character, so they're left out).
+// The old key is the capsule location in 3D cells; the new one the floor primitive the character was on & a 2D cell.
+struct FFloorCacheKey
+{
+	int32_t Floor;
+	int32_t CellX;
+	int32_t CellY;
+	int32_t CellZ;
+
+	bool operator==(const FFloorCacheKey& Other) const
+	{
+		return Floor == Other.Floor && CellX == Other.CellX && CellY == Other.CellY && CellZ == Other.CellZ;
+	}
+};
+
+struct FFloorCacheKeyHash
+{
+	size_t operator()(const FFloorCacheKey& Key) const
+	{
+		return ((static_cast<size_t>(Key.Floor) * 73856093u) ^ (static_cast<size_t>(Key.CellX) * 19349663u) ^
+			(static_cast<size_t>(Key.CellY) * 83492791u) ^ static_cast<size_t>(Key.CellZ));
+	}
+};
+
+// Mirrors FSD5BunnyGunCachedFloor.
+struct FFloorCacheEntry
+{
+	float CapsuleZ;
+	float FloorHeight;
+	int32_t FloorTile;
+};
+
+struct FFloorCacheResult
+{
+	uint64_t NumLookups;
+	uint64_t NumHits;
+	uint64_t NumWrongFloors;
+};
+
+static int32_t GetFloorTile(const FBenchVector& Location)
+{
+	const auto TileX = std::min(std::max(FloorToInt(Location.X / FloorTileSize), 0), FloorTilesPerSide - 1);
+	const auto TileY = std::min(std::max(FloorToInt(Location.Y / FloorTileSize), 0), FloorTilesPerSide - 1);
+	return TileY * FloorTilesPerSide + TileX;
+}
+
+// Simulates the characters querying their floors through the cache. A CellSize of 0 uses the old key.
+static FFloorCacheResult SimulateFloorCache(size_t NumCharacters, float CellSize)
+{
+	const auto bOldKey = (CellSize <= 0.0f);
+	const auto ArenaSize = FloorTileSize * FloorTilesPerSide;
+
+	auto Seed = 0x5D5u;
+	std::vector<float> TileHeights(FloorTilesPerSide * FloorTilesPerSide);
+	for (auto& Height : TileHeights)
+	{
+		Height = (BenchRandom(Seed) < 0.25f ? FloorStepHeight : 0.0f);
+	}
+
+	std::vector<FFloorCacheCharacter> Characters(NumCharacters);
+	for (auto& Character : Characters)
+	{
+		Character.Location = FBenchVector(BenchRandom(Seed) * ArenaSize, BenchRandom(Seed) * ArenaSize, 0.0f);
+		Character.bWalker = BenchRandom(Seed) < FloorWalkerFraction;
+
+		const auto Yaw = BenchRandom(Seed) * 2.0f * Math::Pi;
+		const auto Speed = (Character.bWalker ? FloorWalkSpeed : 800.0f + BenchRandom(Seed) * 1200.0f);
+		Character.Velocity = FBenchVector(std::cos(Yaw) * Speed, std::sin(Yaw) * Speed, 0.0f);
+		Character.Tick = static_cast<uint32_t>(BenchRandom(Seed) * BenchAirTicks);
+		Character.FloorTile = GetFloorTile(Character.Location);
+		Character.FloorHeight = TileHeights[Character.FloorTile];
+	}
+
+	std::unordered_map<FFloorCacheKey, FFloorCacheEntry, FFloorCacheKeyHash> Floors;
+	FFloorCacheResult Result = { 0, 0, 0 };
+
+	for (uint32_t Tick = 0; Tick < FloorCacheTicks; ++Tick)
+	{
+		for (auto& Character : Characters)
+		{
+			// Turn randomly (up to 3 degrees a tick) & bounce off the edges of the arena.
+			const auto Turn = (BenchRandom(Seed) - 0.5f) * 0.1f;
+			const auto TurnCos = std::cos(Turn);
+			const auto TurnSin = std::sin(Turn);
+			const auto Velocity = Character.Velocity;
+			Character.Velocity.X = Velocity.X * TurnCos - Velocity.Y * TurnSin;
+			Character.Velocity.Y = Velocity.X * TurnSin + Velocity.Y * TurnCos;
+			Character.Location.X += Character.Velocity.X * BenchDeltaTime;
+			Character.Location.Y += Character.Velocity.Y * BenchDeltaTime;
+			if (Character.Location.X < 0.0f || Character.Location.X > ArenaSize)
+			{
+				Character.Velocity.X = -Character.Velocity.X;
+				Character.Location.X = std::min(std::max(Character.Location.X, 0.0f), ArenaSize);
+			}
+			if (Character.Location.Y < 0.0f || Character.Location.Y > ArenaSize)
+			{
+				Character.Velocity.Y = -Character.Velocity.Y;
+				Character.Location.Y = std::min(std::max(Character.Location.Y, 0.0f), ArenaSize);
+			}
+
+			if (!Character.bWalker && (++Character.Tick % BenchAirTicks) != 0)
+			{
+				continue;
+			}
+
+			// The capsule is still at the height of the last floor it found (steps up are swept before the floor query).
+			const auto TrueTile = GetFloorTile(Character.Location);
+			const auto TrueHeight = TileHeights[TrueTile];
+			const auto CapsuleZ = std::max(Character.FloorHeight, TrueHeight) + FloorDistance + (BenchRandom(Seed) - 0.5f) * 0.4f;
+
+			FFloorCacheKey Key;
+			if (bOldKey)
+			{
+				Key.Floor = 0;
+				Key.CellX = FloorToInt(Character.Location.X / FloorCacheOldCellSize);
+				Key.CellY = FloorToInt(Character.Location.Y / FloorCacheOldCellSize);
+				Key.CellZ = FloorToInt(CapsuleZ / FloorCacheOldCellSize);
+			}
+			else
+			{
+				Key.Floor = Character.FloorTile;
+				Key.CellX = FloorToInt(Character.Location.X / CellSize);
+				Key.CellY = FloorToInt(Character.Location.Y / CellSize);
+				Key.CellZ = 0;
+			}
+
+			// Mirrors FSD5BunnyGunFloorCache::FindFloor() & AddFloor().
+			++Result.NumLookups;
+			const auto Found = Floors.find(Key);
+			const auto HeightOffset = (Found != Floors.end() ? CapsuleZ - Found->second.CapsuleZ : 0.0f);
+			const auto FloorDist = (Found != Floors.end() ? CapsuleZ - Found->second.FloorHeight : 0.0f);
+			if (Found != Floors.end() && std::abs(HeightOffset) <= FloorCacheMaxHeightOffset && FloorDist >= 0.0f && FloorDist <= FloorSweepDistance)
+			{
+				++Result.NumHits;
+				Result.NumWrongFloors += (Found->second.FloorHeight != TrueHeight ? 1 : 0);
+				Character.FloorHeight = Found->second.FloorHeight;
+				Character.FloorTile = Found->second.FloorTile;
+				continue;
+			}
+
+			if (bOldKey || TrueTile == Key.Floor)
+			{
+				if (Floors.size() >= FloorCacheMaxFloors)
+				{
+					Floors.clear();
+				}
+				FFloorCacheEntry Entry = { CapsuleZ, TrueHeight, TrueTile };
+				Floors[Key] = Entry;
+			}
+			Character.FloorHeight = TrueHeight;
+			Character.FloorTile = TrueTile;
+		}
+	}
+
+	return Result;
+}
+
+// Simulates walking & bunnyhopping characters querying their floors through the floor cache over a grid of flat tiles
+// with steps, and reports the hit rate & how often a hit gave the wrong floor for the old key (the capsule location in
+// 2 cm 3D cells) & the new one (the floor primitive & a 2D cell). Fails if the new key at the default cell size doesn't
+// hit more often than the old one, or gives the wrong floor more than FloorCacheMaxWrongRate of the time.
+int main()
+{
+	auto bPassed = true;
+
+	std::printf("Floor cache over %d x %d tiles of %g cm, %.0f%% walking, for %u ticks\n", FloorTilesPerSide, FloorTilesPerSide,
+		FloorTileSize, FloorWalkerFraction * 100.0f, FloorCacheTicks);
+	std::printf("%-12s %-28s %12s %12s %16s\n", "Characters", "Key", "lookups", "hit rate", "wrong floors");
+	for (const auto NumCharacters : FloorCacheCharacterCounts)
+	{
+		const auto PrintResult = [NumCharacters](const char* Name, const FFloorCacheResult& Result)
+		{
+			std::printf("%-12zu %-28s %12llu %11.1f%% %15.3f%%\n", NumCharacters, Name, static_cast<unsigned long long>(Result.NumLookups),
+				(100.0 * Result.NumHits) / Result.NumLookups, (100.0 * Result.NumWrongFloors) / Result.NumLookups);
+		};
+
+		const auto OldResult = SimulateFloorCache(NumCharacters, 0.0f);
+		PrintResult("2 cm 3D cell (old)", OldResult);
+
+		for (const auto CellSize : FloorCacheCellSizes)
+		{
+			char Name[64];
+			std::snprintf(Name, sizeof(Name), "primitive + %g cm 2D cell", CellSize);
+			const auto Result = SimulateFloorCache(NumCharacters, CellSize);
+			PrintResult(Name, Result);
+
+			if (CellSize == FloorCacheCellSizes[0] &&
+				(Result.NumHits <= OldResult.NumHits || Result.NumWrongFloors > FloorCacheMaxWrongRate * Result.NumLookups))
+			{
+				bPassed = false;
+			}
+		}
+	}
+
+	if (!bPassed)
+	{
+		std::printf("The new key doesn't hit more often than the old one, or gives the wrong floor too often\n");
+	}
+
+	return (bPassed ? 0 : 1);
+}
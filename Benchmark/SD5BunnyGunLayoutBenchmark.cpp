@@ -0,0 +1,738 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGunBenchmarkCommon.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <set>
+
+using namespace SD5BunnyGunBenchmark;
+namespace Math = SD5BunnyGunMovementMath;
+
+// Number of characters, like the largest step of the load test.
+static const size_t LayoutCharacters = 256;
+
+// Frames simulated by a run. Every run is done LayoutRuns times from the same start, keeping the fastest.
+static const uint32_t LayoutFrames = 400;
+static const int LayoutRuns = 3;
+
+// Bytes touched by "the rest of the frame" between two movement passes, evicting the characters from the caches.
+static const size_t LayoutEvictBytes = 16 * 1024 * 1024;
+
+// Size of a cache line.
+static const size_t CacheLineBytes = 64;
+
+// The L1 data cache of the cache model (32 KiB, 8-way, like most desktop CPUs).
+static const size_t ModelCacheBytes = 32 * 1024;
+static const size_t ModelCacheWays = 8;
+
+// Stand-ins for the movement modes.
+static const uint8_t MoveWalking = 1;
+static const uint8_t MoveFalling = 3;
+
+// Flags of the layouts (the uint32 bitfield words of the component).
+static const uint32_t Flag_IsSlowWalking = 1 << 0;
+
+// Stand-in for UCharacterMovementComponent: the state CalcVelocity() & the jump read from it, and the rest of its members
+// (roughly the size of the engine's component). The same for every layout.
+struct FEngineMovementState
+{
+	FBenchVector Velocity;
+	FBenchVector Acceleration;
+	FBenchVector FloorNormal;
+	float MaxWalkSpeed;
+	float MaxAcceleration;
+	float GroundFriction;
+	float JumpZVelocity;
+	uint32_t Tick;
+	uint8_t MovementMode;
+	uint8_t OtherMembers[1500];
+};
+
+// Offset & size of a member read or written by CalcVelocity().
+struct FLayoutField
+{
+	size_t Offset;
+	size_t Size;
+};
+
+#define LAYOUT_FIELD(Type, Member) { offsetof(Type, Member), sizeof(static_cast<Type*>(nullptr)->Member) }
+
+template <typename LayoutType>
+static void CalcVelocity(LayoutType& Movement, float Time);
+
+// The members of USD5BunnyGunCharacterMovement in the order of the baseline: the tuning is read straight from the component &
+// every feature is checked on every move. Bitfields are declared as the uint32 words they are packed into.
+struct FBaselineMovement
+{
+	typedef void (*FSolveFunction)(FBaselineMovement& Movement, float Time);
+
+	FEngineMovementState Engine;
+	uint32_t bCanSlowWalk;
+	float SlowWalkingMaxSpeedMultiplier;
+	uint32_t Flags; // bIsSlowWalking
+	float NoFrictionAfterLandingTime;
+	float LastAirTimestamp;
+	uint32_t bUseEnforcedMaxSpeed;
+	float EnforcedMaxSpeed;
+	float MaxFallAirSpeed;
+	float MaxAirAcceleration;
+	float StopSpeed;
+	uint32_t bEnableTrimping;
+	float MaxTrimpJumpHeightReductionMultiplier;
+	float MaxTrimpVerticalVelocityBoost;
+	float TrimpVerticalVelocityBoostMultiplier;
+	float MaxTrimpHorizSpeedBoost;
+	float TrimpHorizSpeedBoostMultiplier;
+	uint32_t bEnableStamina;
+	float Stamina;
+	float MaxStamina;
+	float StaminaJumpCost;
+	float StaminaRecoveryRate;
+
+	// NOTE: The baseline kept this in a function static shared by every character (a bug fixed since). It is a member here so
+	// that every layout runs the same math.
+	uint8_t LastCalcVeloMovementMode;
+
+	bool IsSlowWalking() const { return (Flags & Flag_IsSlowWalking) != 0; }
+	bool IsStaminaEnabled() const { return bEnableStamina != 0; }
+	bool IsTrimpingEnabled() const { return bEnableTrimping != 0; }
+	bool IsEnforcedMaxSpeedUsed() const { return bUseEnforcedMaxSpeed != 0; }
+	float GetSlowWalkingMaxSpeedMultiplier() const { return SlowWalkingMaxSpeedMultiplier; }
+	float GetNoFrictionAfterLandingTime() const { return NoFrictionAfterLandingTime; }
+	float GetEnforcedMaxSpeed() const { return EnforcedMaxSpeed; }
+	float GetMaxFallAirSpeed() const { return MaxFallAirSpeed; }
+	float GetMaxAirAcceleration() const { return MaxAirAcceleration; }
+	float GetStopSpeed() const { return StopSpeed; }
+	FSolveFunction GetSolveVelocityPhaseFunction() const { return &CalcVelocity<FBaselineMovement>; }
+
+	Math::FTrimpingParams GetTrimpingParams() const
+	{
+		const Math::FTrimpingParams Params = { Engine.JumpZVelocity, MaxTrimpJumpHeightReductionMultiplier, MaxTrimpVerticalVelocityBoost,
+			TrimpVerticalVelocityBoostMultiplier, MaxTrimpHorizSpeedBoost, TrimpHorizSpeedBoostMultiplier };
+		return Params;
+	}
+
+	Math::FStaminaParams GetStaminaParams() const
+	{
+		const Math::FStaminaParams Params = { MaxStamina, StaminaJumpCost, StaminaRecoveryRate };
+		return Params;
+	}
+
+	float GetStaminaAfterJump() const { return Math::GetStaminaAfterJump(GetStaminaParams()); }
+
+	// Everything of this component that CalcVelocity() touches (keep in sync with it).
+	static std::vector<FLayoutField> GetCalcVelocityFields()
+	{
+		const FLayoutField Fields[] =
+		{
+			LAYOUT_FIELD(FBaselineMovement, Flags), LAYOUT_FIELD(FBaselineMovement, SlowWalkingMaxSpeedMultiplier),
+			LAYOUT_FIELD(FBaselineMovement, NoFrictionAfterLandingTime), LAYOUT_FIELD(FBaselineMovement, LastAirTimestamp),
+			LAYOUT_FIELD(FBaselineMovement, bUseEnforcedMaxSpeed), LAYOUT_FIELD(FBaselineMovement, EnforcedMaxSpeed),
+			LAYOUT_FIELD(FBaselineMovement, MaxFallAirSpeed), LAYOUT_FIELD(FBaselineMovement, MaxAirAcceleration),
+			LAYOUT_FIELD(FBaselineMovement, StopSpeed), LAYOUT_FIELD(FBaselineMovement, bEnableTrimping),
+			LAYOUT_FIELD(FBaselineMovement, MaxTrimpJumpHeightReductionMultiplier), LAYOUT_FIELD(FBaselineMovement, MaxTrimpVerticalVelocityBoost),
+			LAYOUT_FIELD(FBaselineMovement, TrimpVerticalVelocityBoostMultiplier), LAYOUT_FIELD(FBaselineMovement, MaxTrimpHorizSpeedBoost),
+			LAYOUT_FIELD(FBaselineMovement, TrimpHorizSpeedBoostMultiplier), LAYOUT_FIELD(FBaselineMovement, bEnableStamina),
+			LAYOUT_FIELD(FBaselineMovement, Stamina), LAYOUT_FIELD(FBaselineMovement, MaxStamina),
+			LAYOUT_FIELD(FBaselineMovement, StaminaJumpCost), LAYOUT_FIELD(FBaselineMovement, StaminaRecoveryRate),
+			LAYOUT_FIELD(FBaselineMovement, LastCalcVeloMovementMode)
+		};
+		return std::vector<FLayoutField>(Fields, Fields + sizeof(Fields) / sizeof(Fields[0]));
+	}
+
+	// Nothing is shared between the components.
+	static std::vector<FLayoutField> GetSharedCalcVelocityFields() { return std::vector<FLayoutField>(); }
+	static size_t GetSharedBytes() { return 0; }
+};
+
+// The members of USD5BunnyGunCharacterMovement with the movement variants & before the hot & cold split: the variant's
+// tuning is copied into every component, between the tuning properties.
+struct FVariantCopyMovement
+{
+	typedef void (*FSolveFunction)(FVariantCopyMovement& Movement, float Time);
+
+	FEngineMovementState Engine;
+	uint32_t bCanSlowWalk;
+	float SlowWalkingMaxSpeedMultiplier;
+	uint32_t Flags; // bIsSlowWalking
+	float NoFrictionAfterLandingTime;
+	float LastAirTimestamp;
+	uint8_t MoveFeatures;
+	uint8_t AccumulatedMoveFeatures;
+	float ServerMoveTimeStamp;
+	uint8_t LastCalcVeloMovementMode;
+	uint32_t MovementVariant;
+	FSolveFunction SolveVelocityPhaseFunction;
+	void (*ApplyJumpFunction)();
+	Math::FTrimpingParams VariantTrimpingParams;
+	Math::FStaminaParams VariantStaminaParams;
+	float VariantStaminaAfterJump;
+	uint32_t bUseSimulatedTime;
+	float SimulatedTimeSeconds;
+	uint32_t bUseEnforcedMaxSpeed;
+	float EnforcedMaxSpeed;
+	float MaxFallAirSpeed;
+	float MaxAirAcceleration;
+	float StopSpeed;
+	uint32_t bEnableTrimping;
+	float MaxTrimpJumpHeightReductionMultiplier;
+	float MaxTrimpVerticalVelocityBoost;
+	float TrimpVerticalVelocityBoostMultiplier;
+	float MaxTrimpHorizSpeedBoost;
+	float TrimpHorizSpeedBoostMultiplier;
+	uint32_t bEnableStamina;
+	float Stamina;
+	float ServerMoveStamina;
+	float StaminaAdjustment;
+	float StaminaAdjustmentTimeStamp;
+	float MaxStamina;
+	float StaminaJumpCost;
+	float StaminaRecoveryRate;
+
+	// The variant has every feature compiled in, so it doesn't check them.
+	bool IsSlowWalking() const { return (Flags & Flag_IsSlowWalking) != 0; }
+	static bool IsStaminaEnabled() { return true; }
+	static bool IsTrimpingEnabled() { return true; }
+	static bool IsEnforcedMaxSpeedUsed() { return true; }
+	float GetSlowWalkingMaxSpeedMultiplier() const { return SlowWalkingMaxSpeedMultiplier; }
+	float GetNoFrictionAfterLandingTime() const { return NoFrictionAfterLandingTime; }
+	float GetEnforcedMaxSpeed() const { return EnforcedMaxSpeed; }
+	float GetMaxFallAirSpeed() const { return MaxFallAirSpeed; }
+	float GetMaxAirAcceleration() const { return MaxAirAcceleration; }
+	float GetStopSpeed() const { return StopSpeed; }
+	const Math::FTrimpingParams& GetTrimpingParams() const { return VariantTrimpingParams; }
+	const Math::FStaminaParams& GetStaminaParams() const { return VariantStaminaParams; }
+	float GetStaminaAfterJump() const { return VariantStaminaAfterJump; }
+	FSolveFunction GetSolveVelocityPhaseFunction() const { return SolveVelocityPhaseFunction; }
+
+	// Everything of this component that CalcVelocity() touches (keep in sync with it).
+	static std::vector<FLayoutField> GetCalcVelocityFields()
+	{
+		const FLayoutField Fields[] =
+		{
+			LAYOUT_FIELD(FVariantCopyMovement, SolveVelocityPhaseFunction), LAYOUT_FIELD(FVariantCopyMovement, LastCalcVeloMovementMode),
+			LAYOUT_FIELD(FVariantCopyMovement, Flags), LAYOUT_FIELD(FVariantCopyMovement, SlowWalkingMaxSpeedMultiplier),
+			LAYOUT_FIELD(FVariantCopyMovement, MaxAirAcceleration), LAYOUT_FIELD(FVariantCopyMovement, LastAirTimestamp),
+			LAYOUT_FIELD(FVariantCopyMovement, NoFrictionAfterLandingTime), LAYOUT_FIELD(FVariantCopyMovement, Stamina),
+			LAYOUT_FIELD(FVariantCopyMovement, VariantStaminaParams), LAYOUT_FIELD(FVariantCopyMovement, StopSpeed),
+			LAYOUT_FIELD(FVariantCopyMovement, MaxFallAirSpeed), LAYOUT_FIELD(FVariantCopyMovement, EnforcedMaxSpeed),
+			LAYOUT_FIELD(FVariantCopyMovement, VariantTrimpingParams), LAYOUT_FIELD(FVariantCopyMovement, VariantStaminaAfterJump)
+		};
+		return std::vector<FLayoutField>(Fields, Fields + sizeof(Fields) / sizeof(Fields[0]));
+	}
+
+	// Nothing is shared between the components.
+	static std::vector<FLayoutField> GetSharedCalcVelocityFields() { return std::vector<FLayoutField>(); }
+	static size_t GetSharedBytes() { return 0; }
+};
+
+struct FCompactMovement;
+
+// Mirrors FSD5BunnyGunMovementArchetype.
+struct FCompactArchetype
+{
+	uint32_t MovementVariant;
+	void (*SolveVelocityPhaseFunction)(FCompactMovement& Movement, float Time);
+	void (*ApplyJumpFunction)();
+	float SlowWalkingMaxSpeedMultiplier;
+	float NoFrictionAfterLandingTime;
+	float EnforcedMaxSpeed;
+	float MaxFallAirSpeed;
+	float MaxAirAcceleration;
+	float StopSpeed;
+	Math::FTrimpingParams TrimpingParams;
+	Math::FStaminaParams StaminaParams;
+	float StaminaAfterJump;
+};
+
+// The members of USD5BunnyGunCharacterMovement as they are declared now: the state used by every move first, then the tuning,
+// which moves only read through the shared archetype.
+struct FCompactMovement
+{
+	typedef void (*FSolveFunction)(FCompactMovement& Movement, float Time);
+
+	FEngineMovementState Engine;
+	const FCompactArchetype* MovementArchetype;
+	float LastAirTimestamp;
+	float ServerMoveTimeStamp;
+	float SimulatedTimeSeconds;
+	float Stamina;
+	float ServerMoveStamina;
+	uint8_t MoveFeatures;
+	uint8_t AccumulatedMoveFeatures;
+	uint8_t LastCalcVeloMovementMode;
+	uint32_t Flags; // bIsSlowWalking, bUseSimulatedTime
+	float StaminaAdjustment;
+	float StaminaAdjustmentTimeStamp;
+	uint32_t TuningFlags; // bCanSlowWalk, bUseEnforcedMaxSpeed, bEnableTrimping, bEnableStamina, bUseFloorCache
+	float SlowWalkingMaxSpeedMultiplier;
+	float NoFrictionAfterLandingTime;
+	float EnforcedMaxSpeed;
+	float MaxFallAirSpeed;
+	float MaxAirAcceleration;
+	float StopSpeed;
+	float MaxTrimpJumpHeightReductionMultiplier;
+	float MaxTrimpVerticalVelocityBoost;
+	float TrimpVerticalVelocityBoostMultiplier;
+	float MaxTrimpHorizSpeedBoost;
+	float TrimpHorizSpeedBoostMultiplier;
+	float MaxStamina;
+	float StaminaJumpCost;
+	float StaminaRecoveryRate;
+
+	// The variant has every feature compiled in, so it doesn't check them.
+	bool IsSlowWalking() const { return (Flags & Flag_IsSlowWalking) != 0; }
+	static bool IsStaminaEnabled() { return true; }
+	static bool IsTrimpingEnabled() { return true; }
+	static bool IsEnforcedMaxSpeedUsed() { return true; }
+	float GetSlowWalkingMaxSpeedMultiplier() const { return MovementArchetype->SlowWalkingMaxSpeedMultiplier; }
+	float GetNoFrictionAfterLandingTime() const { return MovementArchetype->NoFrictionAfterLandingTime; }
+	float GetEnforcedMaxSpeed() const { return MovementArchetype->EnforcedMaxSpeed; }
+	float GetMaxFallAirSpeed() const { return MovementArchetype->MaxFallAirSpeed; }
+	float GetMaxAirAcceleration() const { return MovementArchetype->MaxAirAcceleration; }
+	float GetStopSpeed() const { return MovementArchetype->StopSpeed; }
+	const Math::FTrimpingParams& GetTrimpingParams() const { return MovementArchetype->TrimpingParams; }
+	const Math::FStaminaParams& GetStaminaParams() const { return MovementArchetype->StaminaParams; }
+	float GetStaminaAfterJump() const { return MovementArchetype->StaminaAfterJump; }
+	FSolveFunction GetSolveVelocityPhaseFunction() const { return MovementArchetype->SolveVelocityPhaseFunction; }
+
+	// Everything of this component that CalcVelocity() touches (keep in sync with it).
+	static std::vector<FLayoutField> GetCalcVelocityFields()
+	{
+		const FLayoutField Fields[] =
+		{
+			LAYOUT_FIELD(FCompactMovement, MovementArchetype), LAYOUT_FIELD(FCompactMovement, LastCalcVeloMovementMode),
+			LAYOUT_FIELD(FCompactMovement, Flags), LAYOUT_FIELD(FCompactMovement, LastAirTimestamp),
+			LAYOUT_FIELD(FCompactMovement, Stamina)
+		};
+		return std::vector<FLayoutField>(Fields, Fields + sizeof(Fields) / sizeof(Fields[0]));
+	}
+
+	// Everything of the shared archetype that CalcVelocity() touches.
+	static std::vector<FLayoutField> GetSharedCalcVelocityFields()
+	{
+		return std::vector<FLayoutField>(1, FLayoutField{ 0, sizeof(FCompactArchetype) });
+	}
+	static size_t GetSharedBytes() { return sizeof(FCompactArchetype); }
+};
+
+#undef LAYOUT_FIELD
+
+// The engine's members read by CalcVelocity() & the jump, which are the same for every layout.
+static std::vector<FLayoutField> GetEngineCalcVelocityFields()
+{
+	return std::vector<FLayoutField>(1, FLayoutField{ 0, offsetof(FEngineMovementState, MovementMode) + 1 });
+}
+
+// One CalcVelocity() & jump of a character: GetMaxSpeed(), GetMaxAcceleration(), ShouldApplyGroundFriction() & the velocity
+// phase with stamina, trimping & the enforced max speed. Reads the tuning through the accessors of the layout, so every layout
+// runs the exact same math.
+template <typename LayoutType>
+static void CalcVelocity(LayoutType& Movement, float Time)
+{
+	auto& Engine = Movement.Engine;
+	const auto DeltaTime = BenchDeltaTime;
+
+	// Falling is latched for one extra call after landing.
+	const auto Mode = (Movement.LastCalcVeloMovementMode == MoveFalling ? MoveFalling : Engine.MovementMode);
+	const auto MaxSpeed = Engine.MaxWalkSpeed * (Movement.IsSlowWalking() ? Movement.GetSlowWalkingMaxSpeedMultiplier() : 1.0f);
+	const auto MaxAccel = (Mode == MoveFalling ? Movement.GetMaxAirAcceleration() : Engine.MaxAcceleration);
+	const auto bApplyGroundFriction = (Mode == MoveWalking && Time >= Movement.LastAirTimestamp + Movement.GetNoFrictionAfterLandingTime());
+
+	auto Velocity = Engine.Velocity;
+	if (Movement.IsStaminaEnabled())
+	{
+		Movement.Stamina = Math::DecayStamina(Movement.Stamina, DeltaTime);
+		if (Mode == MoveWalking && Movement.Stamina > 0.0f)
+		{
+			const auto WalkMultiplier = Math::GetStaminaWalkSpeedMultiplier(Movement.Stamina, DeltaTime, Movement.GetStaminaParams());
+			Velocity.X *= WalkMultiplier;
+			Velocity.Y *= WalkMultiplier;
+		}
+	}
+
+	if (bApplyGroundFriction)
+	{
+		Math::ApplyFriction(Velocity, DeltaTime, Engine.GroundFriction, 1.0f, Movement.GetStopSpeed());
+	}
+
+	if (Mode == MoveWalking)
+	{
+		Math::ApplyAcceleration(Velocity, DeltaTime, 1.0f, Engine.Acceleration, MaxSpeed, MaxAccel);
+	}
+	else
+	{
+		Math::ApplyAirAcceleration(Velocity, DeltaTime, 1.0f, Engine.Acceleration, MaxSpeed, Movement.GetMaxFallAirSpeed(), MaxAccel);
+	}
+	if (Movement.IsEnforcedMaxSpeedUsed())
+	{
+		Velocity = Math::GetClampedToMaxSizePrecise(Velocity, Movement.GetEnforcedMaxSpeed());
+	}
+
+	// Jump straight away again.
+	if (Engine.MovementMode == MoveWalking)
+	{
+		Velocity.Z = Engine.JumpZVelocity;
+		if (Movement.IsTrimpingEnabled())
+		{
+			Math::ApplyTrimpingVelocity(Velocity, Engine.FloorNormal, Movement.GetTrimpingParams());
+		}
+		if (Movement.IsStaminaEnabled())
+		{
+			Velocity.Z *= Math::GetStaminaJumpVelocityMultiplier(Movement.Stamina, Movement.GetStaminaParams());
+			Movement.Stamina = Movement.GetStaminaAfterJump();
+		}
+	}
+
+	Engine.Velocity = Velocity;
+	Movement.LastCalcVeloMovementMode = Engine.MovementMode;
+	if (Engine.MovementMode == MoveFalling)
+	{
+		Movement.LastAirTimestamp = Time;
+	}
+}
+
+// The rest of the move, which is the same for every layout: turns the wish direction & lands for a single tick between hops.
+static void FinishMove(FEngineMovementState& Engine)
+{
+	// cos & sin of 2 degrees.
+	const auto TurnCos = 0.99939083f;
+	const auto TurnSin = 0.03489950f;
+	const auto Wish = Engine.Acceleration;
+	Engine.Acceleration.X = Wish.X * TurnCos - Wish.Y * TurnSin;
+	Engine.Acceleration.Y = Wish.X * TurnSin + Wish.Y * TurnCos;
+
+	++Engine.Tick;
+	Engine.MovementMode = ((Engine.Tick % BenchAirTicks) == 0 ? MoveWalking : MoveFalling);
+}
+
+// Sets up the engine state & tuning of a component from a benchmark character, with the default tuning values.
+template <typename LayoutType>
+static void InitMovement(LayoutType& Movement, const FBenchCharacter& Character)
+{
+	std::memset(static_cast<void*>(&Movement), 0, sizeof(Movement));
+
+	const FBenchTuning Tuning;
+	auto& Engine = Movement.Engine;
+	Engine.Velocity = Character.Velocity;
+	Engine.Acceleration = Character.WishDirection;
+	Engine.FloorNormal = Character.FloorNormal;
+	Engine.MaxWalkSpeed = Tuning.MaxWalkSpeed;
+	Engine.MaxAcceleration = Tuning.MaxAcceleration;
+	Engine.GroundFriction = Tuning.GroundFriction;
+	Engine.JumpZVelocity = Tuning.Trimping.JumpZVelocity;
+	Engine.Tick = Character.Tick;
+	Engine.MovementMode = ((Engine.Tick % BenchAirTicks) == 0 ? MoveWalking : MoveFalling);
+
+	Movement.SlowWalkingMaxSpeedMultiplier = 0.3f;
+	Movement.EnforcedMaxSpeed = Tuning.EnforcedMaxSpeed;
+	Movement.MaxFallAirSpeed = Tuning.MaxFallAirSpeed;
+	Movement.MaxAirAcceleration = Tuning.MaxAirAcceleration;
+	Movement.StopSpeed = Tuning.StopSpeed;
+	Movement.MaxTrimpJumpHeightReductionMultiplier = Tuning.Trimping.MaxTrimpJumpHeightReductionMultiplier;
+	Movement.MaxTrimpVerticalVelocityBoost = Tuning.Trimping.MaxTrimpVerticalVelocityBoost;
+	Movement.TrimpVerticalVelocityBoostMultiplier = Tuning.Trimping.TrimpVerticalVelocityBoostMultiplier;
+	Movement.MaxTrimpHorizSpeedBoost = Tuning.Trimping.MaxTrimpHorizSpeedBoost;
+	Movement.TrimpHorizSpeedBoostMultiplier = Tuning.Trimping.TrimpHorizSpeedBoostMultiplier;
+	Movement.MaxStamina = Tuning.Stamina.MaxStamina;
+	Movement.StaminaJumpCost = Tuning.Stamina.StaminaJumpCost;
+	Movement.StaminaRecoveryRate = Tuning.Stamina.StaminaRecoveryRate;
+}
+
+// Enables every feature of the baseline, which checks them on every move.
+static void UpdateMovementVariant(FBaselineMovement& Movement, const FCompactArchetype& /*Archetype*/)
+{
+	Movement.bUseEnforcedMaxSpeed = 1;
+	Movement.bEnableTrimping = 1;
+	Movement.bEnableStamina = 1;
+}
+
+// Copies the variant tuning into the component, like UpdateMovementVariant() did before the split.
+static void UpdateMovementVariant(FVariantCopyMovement& Movement, const FCompactArchetype& Archetype)
+{
+	Movement.SolveVelocityPhaseFunction = &CalcVelocity<FVariantCopyMovement>;
+	Movement.VariantTrimpingParams = Archetype.TrimpingParams;
+	Movement.VariantStaminaParams = Archetype.StaminaParams;
+	Movement.VariantStaminaAfterJump = Archetype.StaminaAfterJump;
+}
+
+// Points the component at the shared archetype, like UpdateMovementVariant() does.
+static void UpdateMovementVariant(FCompactMovement& Movement, const FCompactArchetype& Archetype)
+{
+	Movement.MovementArchetype = &Archetype;
+}
+
+// Model of a set associative cache with LRU replacement, fed with the cache lines a move touches. Models the data accesses of
+// the layout only (no prefetching, code or stack), so it compares layouts rather than predicting a CPU's miss counts.
+class FCacheModel
+{
+public:
+	FCacheModel() :
+	Lines((ModelCacheBytes / CacheLineBytes), 0),
+	Ages((ModelCacheBytes / CacheLineBytes), 0),
+	Clock(0),
+	Misses(0)
+	{ }
+
+	// Empties the cache, like the rest of a game frame would.
+	void Flush()
+	{
+		std::fill(Lines.begin(), Lines.end(), 0);
+	}
+
+	// Touches every cache line of the bytes starting at Address.
+	void Touch(uintptr_t Address, size_t Size)
+	{
+		for (auto Line = Address / CacheLineBytes; Line <= (Address + Size - 1) / CacheLineBytes; ++Line)
+		{
+			TouchLine(Line);
+		}
+	}
+
+	uint64_t GetMisses() const { return Misses; }
+	void ResetMisses() { Misses = 0; }
+
+private:
+	void TouchLine(uintptr_t Line)
+	{
+		const auto NumSets = Lines.size() / ModelCacheWays;
+		const auto First = (Line % NumSets) * ModelCacheWays;
+		const auto Tag = Line + 1; // 0 is an empty way.
+		auto Oldest = First;
+		++Clock;
+
+		for (auto Way = First; Way < First + ModelCacheWays; ++Way)
+		{
+			if (Lines[Way] == Tag)
+			{
+				Ages[Way] = Clock;
+				return;
+			}
+			if (Lines[Way] == 0 || (Lines[Oldest] != 0 && Ages[Way] < Ages[Oldest]))
+			{
+				Oldest = Way;
+			}
+		}
+
+		++Misses;
+		Lines[Oldest] = Tag;
+		Ages[Oldest] = Clock;
+	}
+
+	std::vector<uintptr_t> Lines;
+	std::vector<uint64_t> Ages;
+	uint64_t Clock;
+	uint64_t Misses;
+};
+
+// Measurements of a layout.
+struct FLayoutResult
+{
+	double ColdNs;
+	double WarmNs;
+	double ColdMisses;
+	double WarmMisses;
+	std::vector<FBenchVector> Velocities;
+	std::vector<float> Stamina;
+};
+
+// Returns the number of distinct cache lines the fields touch, for an object starting on a cache line.
+static size_t GetCacheLinesTouched(const std::vector<FLayoutField>& Fields)
+{
+	std::set<size_t> Lines;
+	for (const auto& Field : Fields)
+	{
+		const auto Size = (Field.Size > 0 ? Field.Size : 1);
+		for (auto Line = Field.Offset / CacheLineBytes; Line <= (Field.Offset + Size - 1) / CacheLineBytes; ++Line)
+		{
+			Lines.insert(Line);
+		}
+	}
+
+	return Lines.size();
+}
+
+// Feeds the fields of every character touched by one pass of CalcVelocity() to the cache model, in the order of the pass.
+template <typename LayoutType>
+static void TouchLayout(FCacheModel& Cache, const std::vector<LayoutType*>& Order, const FCompactArchetype& Archetype)
+{
+	const auto EngineFields = GetEngineCalcVelocityFields();
+	const auto OwnFields = LayoutType::GetCalcVelocityFields();
+	const auto SharedFields = LayoutType::GetSharedCalcVelocityFields();
+	for (const auto Movement : Order)
+	{
+		const auto Address = reinterpret_cast<uintptr_t>(Movement);
+		for (const auto& Field : EngineFields)
+		{
+			Cache.Touch(Address + Field.Offset, Field.Size);
+		}
+		for (const auto& Field : OwnFields)
+		{
+			Cache.Touch(Address + Field.Offset, Field.Size);
+		}
+		for (const auto& Field : SharedFields)
+		{
+			Cache.Touch(reinterpret_cast<uintptr_t>(&Archetype) + Field.Offset, Field.Size);
+		}
+	}
+}
+
+// Simulates LayoutFrames frames of every character, each component on its own cache lines & visited in a shuffled order (like
+// components allocated one at a time), with the caches trashed between frames like the rest of a game frame does (cold) &
+// without (warm). Times the fastest run in ns per CalcVelocity(), and counts the misses per CalcVelocity() of the cache model
+// for one cold pass & one warm pass (after a pass that warms it up).
+template <typename LayoutType>
+static FLayoutResult RunLayout(const FCompactArchetype& Archetype)
+{
+	const auto Stride = ((sizeof(LayoutType) + CacheLineBytes - 1) / CacheLineBytes) * CacheLineBytes;
+	std::vector<unsigned char> Memory(Stride * LayoutCharacters + CacheLineBytes);
+	const auto AlignedAddress = (reinterpret_cast<uintptr_t>(Memory.data()) + CacheLineBytes - 1) & ~static_cast<uintptr_t>(CacheLineBytes - 1);
+	const auto Base = reinterpret_cast<unsigned char*>(AlignedAddress);
+
+	// The same shuffled order for every run & layout.
+	std::vector<LayoutType*> Order(LayoutCharacters);
+	for (size_t Index = 0; Index < LayoutCharacters; ++Index)
+	{
+		Order[Index] = reinterpret_cast<LayoutType*>(Base + Stride * Index);
+	}
+	auto Seed = 0xB0Bu;
+	for (auto Index = LayoutCharacters - 1; Index > 0; --Index)
+	{
+		const auto SwapIndex = static_cast<size_t>(BenchRandom(Seed) * (Index + 1)) % (Index + 1);
+		const auto Swapped = Order[Index];
+		Order[Index] = Order[SwapIndex];
+		Order[SwapIndex] = Swapped;
+	}
+
+	std::vector<unsigned char> EvictBuffer(LayoutEvictBytes, 1);
+	FLayoutResult Result;
+	Result.ColdNs = 0.0;
+	Result.WarmNs = 0.0;
+
+	for (auto Pass = 0; Pass < 2; ++Pass)
+	{
+		const auto bEvict = (Pass == 1);
+		for (auto Run = 0; Run < LayoutRuns; ++Run)
+		{
+			const auto Characters = MakeBenchCharacters(LayoutCharacters);
+			for (size_t Index = 0; Index < LayoutCharacters; ++Index)
+			{
+				auto& Movement = *reinterpret_cast<LayoutType*>(Base + Stride * Index);
+				InitMovement(Movement, Characters[Index]);
+				UpdateMovementVariant(Movement, Archetype);
+			}
+
+			auto Seconds = 0.0;
+			for (uint32_t Frame = 0; Frame < LayoutFrames; ++Frame)
+			{
+				for (size_t Offset = 0; bEvict && Offset < EvictBuffer.size(); Offset += CacheLineBytes)
+				{
+					++EvictBuffer[Offset];
+				}
+
+				const auto Time = Frame * BenchDeltaTime;
+				const FBenchTimer Timer;
+				for (const auto Movement : Order)
+				{
+					Movement->GetSolveVelocityPhaseFunction()(*Movement, Time);
+					FinishMove(Movement->Engine);
+				}
+				Seconds += Timer.GetElapsedSeconds();
+			}
+
+			const auto Ns = (Seconds * 1.e9) / (static_cast<double>(LayoutCharacters) * LayoutFrames);
+			auto& BestNs = (bEvict ? Result.ColdNs : Result.WarmNs);
+			if (Run == 0 || Ns < BestNs)
+			{
+				BestNs = Ns;
+			}
+		}
+
+		// Both passes leave the characters in the same state.
+		if (bEvict)
+		{
+			continue;
+		}
+		for (size_t Index = 0; Index < LayoutCharacters; ++Index)
+		{
+			const auto& Movement = *reinterpret_cast<const LayoutType*>(Base + Stride * Index);
+			Result.Velocities.push_back(Movement.Engine.Velocity);
+			Result.Stamina.push_back(Movement.Stamina);
+		}
+	}
+
+	FCacheModel Cache;
+	TouchLayout(Cache, Order, Archetype);
+	Result.ColdMisses = static_cast<double>(Cache.GetMisses()) / LayoutCharacters;
+	Cache.ResetMisses();
+	TouchLayout(Cache, Order, Archetype);
+	Result.WarmMisses = static_cast<double>(Cache.GetMisses()) / LayoutCharacters;
+
+	// NOTE: Keeps the eviction from being thrown away.
+	volatile auto EvictSink = EvictBuffer[0];
+	(void)EvictSink;
+
+	return Result;
+}
+
+// Returns whether or not both layouts left every character in the exact same state.
+static bool AreLayoutResultsIdentical(const FLayoutResult& A, const FLayoutResult& B)
+{
+	return std::memcmp(A.Velocities.data(), B.Velocities.data(), A.Velocities.size() * sizeof(FBenchVector)) == 0 &&
+		std::memcmp(A.Stamina.data(), B.Stamina.data(), A.Stamina.size() * sizeof(float)) == 0;
+}
+
+template <typename LayoutType>
+static void PrintLayout(const char* Name, const FLayoutResult& Result)
+{
+	const auto OwnBytes = sizeof(LayoutType) - sizeof(FEngineMovementState);
+	const auto SharedBytes = LayoutType::GetSharedBytes();
+	const auto OwnLines = GetCacheLinesTouched(LayoutType::GetCalcVelocityFields());
+	const auto SharedLines = GetCacheLinesTouched(LayoutType::GetSharedCalcVelocityFields());
+
+	std::printf("%-14s %6zu %7zu %10.2f %6zu %7zu %11.2f %11.2f %9.2f %9.2f\n", Name, OwnBytes, SharedBytes,
+		OwnBytes + static_cast<double>(SharedBytes) / LayoutCharacters, OwnLines, SharedLines, Result.ColdMisses, Result.WarmMisses,
+		Result.ColdNs, Result.WarmNs);
+}
+
+// Compares the layout of the Bunny Gun members of the movement component at 256 characters: the baseline (tuning read from
+// the component, features checked every move), the movement variants with their tuning copied into every component, and the
+// current hot & cold split with the shared archetype. Reports the bytes per character (the engine's members are the same for
+// every layout & not counted), the cache lines of the component & of the shared archetype touched by a CalcVelocity(), the
+// misses per CalcVelocity() of a modelled 32 KiB 8-way L1 data cache starting empty (cold) & after a pass (warm), and the time
+// of a CalcVelocity() with the caches trashed between frames (cold) & without (warm). The misses are modelled, not measured,
+// and the times vary by a few percent between runs. Fails if the layouts don't give the exact same velocities & stamina.
+int main()
+{
+	const FBenchTuning Tuning;
+	FCompactArchetype Archetype;
+	std::memset(static_cast<void*>(&Archetype), 0, sizeof(Archetype));
+	Archetype.SolveVelocityPhaseFunction = &CalcVelocity<FCompactMovement>;
+	Archetype.SlowWalkingMaxSpeedMultiplier = 0.3f;
+	Archetype.EnforcedMaxSpeed = Tuning.EnforcedMaxSpeed;
+	Archetype.MaxFallAirSpeed = Tuning.MaxFallAirSpeed;
+	Archetype.MaxAirAcceleration = Tuning.MaxAirAcceleration;
+	Archetype.StopSpeed = Tuning.StopSpeed;
+	Archetype.TrimpingParams = Tuning.Trimping;
+	Archetype.StaminaParams = Tuning.Stamina;
+	Archetype.StaminaAfterJump = Math::GetStaminaAfterJump(Tuning.Stamina);
+
+	const auto Baseline = RunLayout<FBaselineMovement>(Archetype);
+	const auto VariantCopy = RunLayout<FVariantCopyMovement>(Archetype);
+	const auto Compact = RunLayout<FCompactMovement>(Archetype);
+
+	std::printf("Movement component layout, %zu characters x %u frames (engine members: %zu bytes, %zu cache lines read by CalcVelocity)\n",
+		LayoutCharacters, LayoutFrames, sizeof(FEngineMovementState), GetCacheLinesTouched(GetEngineCalcVelocityFields()));
+	std::printf("%-14s %6s %7s %10s %6s %7s %11s %11s %9s %9s\n", "Layout", "bytes", "shared", "bytes/char", "lines", "shared",
+		"cold miss", "warm miss", "cold ns", "warm ns");
+	PrintLayout<FBaselineMovement>("baseline", Baseline);
+	PrintLayout<FVariantCopyMovement>("variant copies", VariantCopy);
+	PrintLayout<FCompactMovement>("compact", Compact);
+
+	const auto bIdentical = AreLayoutResultsIdentical(Baseline, Compact) && AreLayoutResultsIdentical(VariantCopy, Compact);
+	std::printf("%s\n", (bIdentical ? "ok" : "DIFFERENT RESULT"));
+
+	return (bIdentical ? 0 : 1);
+}
@@ -0,0 +1,302 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGunBenchmarkCommon.h"
+
+#include <algorithm>
+
+using namespace SD5BunnyGunBenchmark;
+
+// Player counts measured. Every player is relevant to every other, like on a small map.
+static const size_t LookPlayerCounts[] = { 32, 64 };
+
+// Seconds of play simulated per player, at the server's net tick rate (a net update of every character each tick).
+static const uint32_t LookSeconds = 600;
+static const uint32_t LookNetTickRate = 30;
+
+// Property handle written before every changed property (FRepLayout packs it into a byte for the handles of a character).
+static const uint32_t LookPropertyHandleBits = 8;
+
+// Mirrors LOOK_ROTATION_PITCH_BITS, LOOK_ROTATION_YAW_BITS & the default of LookRotationReplicationThreshold.
+static const int32_t LookPitchBits = 8;
+static const int32_t LookYawBits = 9;
+static const float LookThreshold = 0.5f;
+
+// The old 16 bit pitch & yaw (see FRotator::CompressAxisToShort()) and its threshold.
+static const float LookShortThreshold = 0.25f;
+
+// How LookRotation is replicated.
+enum ELookReplication
+{
+	// LookRotation as an FRotator, sent whenever it changes (see FRotator::SerializeCompressed()).
+	LookReplication_Rotator,
+
+	// Pitch & yaw quantized to 16 bits each, sent once they move past LookShortThreshold.
+	LookReplication_Short,
+
+	// FReplicatedLookRotation: 8 bit pitch & 9 bit yaw, sent once they move past LookThreshold.
+	LookReplication_Quantized
+};
+
+struct FLookRotation
+{
+	float Pitch;
+	float Yaw;
+};
+
+struct FLookResult
+{
+	uint64_t NumUpdates;
+	uint64_t NumBits;
+	double ErrorSum;
+	float MaxError;
+	uint64_t NumSamples;
+};
+
+// Stand-in for FRotator::NormalizeAxis().
+static float NormalizeAxis(float Angle)
+{
+	Angle = std::fmod(Angle, 360.0f);
+	if (Angle < 0.0f)
+	{
+		Angle += 360.0f;
+	}
+	return (Angle > 180.0f ? Angle - 360.0f : Angle);
+}
+
+static int32_t RoundToInt(float Value)
+{
+	return static_cast<int32_t>(std::floor(Value + 0.5f));
+}
+
+// Mirrors FRotator::CompressAxisToByte() & DecompressAxisFromByte().
+static uint8_t CompressAxisToByte(float Angle)
+{
+	return static_cast<uint8_t>(RoundToInt(Angle * 256.0f / 360.0f) & 0xFF);
+}
+
+static float DecompressAxisFromByte(uint8_t Angle)
+{
+	return Angle * 360.0f / 256.0f;
+}
+
+// Mirrors FRotator::CompressAxisToShort() & DecompressAxisFromShort().
+static uint16_t CompressAxisToShort(float Angle)
+{
+	return static_cast<uint16_t>(RoundToInt(Angle * 65536.0f / 360.0f) & 0xFFFF);
+}
+
+static float DecompressAxisFromShort(uint16_t Angle)
+{
+	return Angle * 360.0f / 65536.0f;
+}
+
+// Mirrors FReplicatedLookRotation::SetRotation() & GetRotation().
+static const int32_t LookPitchSteps = (1 << (LookPitchBits - 1)) - 1;
+static const int32_t LookYawSteps = (1 << LookYawBits);
+
+static void QuantizeLookRotation(const FLookRotation& Rotation, uint16_t& OutPitch, uint16_t& OutYaw)
+{
+	const auto ClampedPitch = std::min(std::max(NormalizeAxis(Rotation.Pitch), -90.0f), 90.0f);
+	OutPitch = static_cast<uint16_t>(RoundToInt(ClampedPitch * (LookPitchSteps / 90.0f)) + LookPitchSteps);
+	const auto Yaw = NormalizeAxis(Rotation.Yaw);
+	OutYaw = static_cast<uint16_t>(RoundToInt((Yaw < 0.0f ? Yaw + 360.0f : Yaw) * (LookYawSteps / 360.0f)) & (LookYawSteps - 1));
+}
+
+static FLookRotation DequantizeLookRotation(uint16_t Pitch, uint16_t Yaw)
+{
+	FLookRotation Rotation;
+	Rotation.Pitch = (static_cast<int32_t>(Pitch) - LookPitchSteps) * (90.0f / LookPitchSteps);
+	Rotation.Yaw = Yaw * (360.0f / LookYawSteps);
+	return Rotation;
+}
+
+static float GetLookError(const FLookRotation& A, const FLookRotation& B)
+{
+	return std::max(std::abs(NormalizeAxis(A.Pitch - B.Pitch)), std::abs(NormalizeAxis(A.Yaw - B.Yaw)));
+}
+
+// Creates the look rotation of a player for every net tick. Players switch every 0.5-3 seconds between strafe-jumping
+// (sweeping the yaw one way then the other every hop), aiming (slow tracking with mouse jitter) & keeping the mouse still.
+static std::vector<FLookRotation> MakeLookTrace(uint32_t Seed)
+{
+	const auto NumTicks = LookSeconds * LookNetTickRate;
+	const auto DeltaTime = 1.0f / LookNetTickRate;
+	std::vector<FLookRotation> Trace(NumTicks);
+
+	FLookRotation Look = { (BenchRandom(Seed) - 0.5f) * 20.0f, BenchRandom(Seed) * 360.0f };
+	uint32_t Tick = 0;
+	while (Tick < NumTicks)
+	{
+		const auto Mode = BenchRandom(Seed);
+		const auto ModeTicks = static_cast<uint32_t>((0.5f + BenchRandom(Seed) * 2.5f) * LookNetTickRate);
+		const auto StrafeRate = (120.0f + BenchRandom(Seed) * 180.0f) * (BenchRandom(Seed) < 0.5f ? -1.0f : 1.0f);
+		const auto AimPitchRate = (BenchRandom(Seed) - 0.5f) * 40.0f;
+		const auto AimYawRate = (BenchRandom(Seed) - 0.5f) * 80.0f;
+
+		for (uint32_t ModeTick = 0; ModeTick < ModeTicks && Tick < NumTicks; ++ModeTick, ++Tick)
+		{
+			if (Mode < 0.45f)
+			{
+				// Turn the other way every hop (BenchAirTicks at 60 Hz).
+				const auto bTurnLeft = ((ModeTick * 2 / BenchAirTicks) % 2) == 0;
+				Look.Yaw += (bTurnLeft ? StrafeRate : -StrafeRate) * DeltaTime;
+				Look.Pitch += (BenchRandom(Seed) - 0.5f) * 0.5f;
+			}
+			else if (Mode < 0.85f)
+			{
+				Look.Pitch += AimPitchRate * DeltaTime + (BenchRandom(Seed) - 0.5f) * 0.1f;
+				Look.Yaw += AimYawRate * DeltaTime + (BenchRandom(Seed) - 0.5f) * 0.1f;
+			}
+
+			Look.Pitch = std::min(std::max(Look.Pitch, -89.0f), 89.0f);
+			Look.Yaw = NormalizeAxis(Look.Yaw);
+			Trace[Tick] = Look;
+		}
+	}
+
+	return Trace;
+}
+
+// Replicates the look trace of a character to a client like the server would, counting the updates & bits sent and the error
+// of the look rotation the client sees.
+static void ReplicateLookTrace(const std::vector<FLookRotation>& Trace, ELookReplication Replication, FLookResult& Result)
+{
+	auto bHasSent = false;
+	FLookRotation SentRotation = { 0.0f, 0.0f };
+	uint8_t SentBytes[3] = { 0, 0, 0 };
+	uint16_t SentPitch = 0;
+	uint16_t SentYaw = 0;
+	FLookRotation ClientRotation = { 0.0f, 0.0f };
+
+	for (const auto& Look : Trace)
+	{
+		auto bSend = false;
+		uint32_t Bits = 0;
+
+		switch (Replication)
+		{
+		case LookReplication_Rotator:
+		{
+			// The property is compared as floats, so any change is sent; every axis is a bit, plus a byte when not 0.
+			bSend = (!bHasSent || Look.Pitch != SentRotation.Pitch || Look.Yaw != SentRotation.Yaw);
+			if (bSend)
+			{
+				SentRotation = Look;
+				SentBytes[0] = CompressAxisToByte(Look.Pitch);
+				SentBytes[1] = CompressAxisToByte(Look.Yaw);
+				Bits = 3 + (SentBytes[0] != 0 ? 8 : 0) + (SentBytes[1] != 0 ? 8 : 0) + (SentBytes[2] != 0 ? 8 : 0);
+				ClientRotation.Pitch = DecompressAxisFromByte(SentBytes[0]);
+				ClientRotation.Yaw = DecompressAxisFromByte(SentBytes[1]);
+			}
+			break;
+		}
+		case LookReplication_Short:
+		{
+			const auto Threshold = static_cast<int32_t>(LookShortThreshold * (65536.0f / 360.0f));
+			const auto Pitch = CompressAxisToShort(Look.Pitch);
+			const auto Yaw = CompressAxisToShort(Look.Yaw);
+			bSend = (!bHasSent || std::abs(static_cast<int32_t>(static_cast<int16_t>(Pitch - SentPitch))) > Threshold ||
+				std::abs(static_cast<int32_t>(static_cast<int16_t>(Yaw - SentYaw))) > Threshold);
+			if (bSend)
+			{
+				SentPitch = Pitch;
+				SentYaw = Yaw;
+				Bits = 32;
+				ClientRotation.Pitch = DecompressAxisFromShort(Pitch);
+				ClientRotation.Yaw = DecompressAxisFromShort(Yaw);
+			}
+			break;
+		}
+		case LookReplication_Quantized:
+		{
+			// Mirrors FReplicatedLookRotation::ExceedsThreshold(); the property is only sent if its quantized value changed.
+			if (!bHasSent || GetLookError(Look, DequantizeLookRotation(SentPitch, SentYaw)) > LookThreshold)
+			{
+				uint16_t Pitch;
+				uint16_t Yaw;
+				QuantizeLookRotation(Look, Pitch, Yaw);
+				bSend = (!bHasSent || Pitch != SentPitch || Yaw != SentYaw);
+				SentPitch = Pitch;
+				SentYaw = Yaw;
+			}
+			if (bSend)
+			{
+				Bits = LookPitchBits + LookYawBits;
+				ClientRotation = DequantizeLookRotation(SentPitch, SentYaw);
+			}
+			break;
+		}
+		}
+
+		if (bSend)
+		{
+			bHasSent = true;
+			++Result.NumUpdates;
+			Result.NumBits += LookPropertyHandleBits + Bits;
+		}
+
+		const auto Error = GetLookError(Look, ClientRotation);
+		Result.ErrorSum += Error;
+		Result.MaxError = std::max(Result.MaxError, Error);
+		++Result.NumSamples;
+	}
+}
+
+// Simulates the look rotations of NumPlayers players replicated to every other player for LookSeconds, and reports the
+// updates & bytes per second of a character, the bytes per second each client receives & the server sends in all, and the
+// mean & max error of the look rotations the clients see.
+static FLookResult RunLookReplication(size_t NumPlayers, ELookReplication Replication)
+{
+	FLookResult Result = {};
+	for (size_t Player = 0; Player < NumPlayers; ++Player)
+	{
+		ReplicateLookTrace(MakeLookTrace(0x5D5u + static_cast<uint32_t>(Player) * 7919u), Replication, Result);
+	}
+
+	return Result;
+}
+
+// Reports the LookRotation bandwidth of a replicated FRotator (the baseline), 16 bit pitch & yaw with a 0.25 degree threshold,
+// and FReplicatedLookRotation at 32 & 64 players, counting the property handle & payload bits of every update. Fails if
+// FReplicatedLookRotation isn't smaller than the FRotator, or clients see it off by more than LookThreshold.
+int main()
+{
+	auto bPassed = true;
+
+	std::printf("LookRotation replication, %u s at %u net updates/s, every player relevant to every other\n", LookSeconds, LookNetTickRate);
+	std::printf("%-7s %-26s %10s %8s %12s %12s %13s %10s %9s\n", "Players", "Replication", "updates/s", "bits", "B/s/player",
+		"B/s/client", "server KB/s", "mean err", "max err");
+
+	for (const auto NumPlayers : LookPlayerCounts)
+	{
+		const char* Names[] = { "FRotator (baseline)", "16 bit pitch/yaw, 0.25 deg", "8/9 bit pitch/yaw, 0.5 deg" };
+		double RotatorBytes = 0.0;
+
+		for (auto Replication = 0; Replication <= LookReplication_Quantized; ++Replication)
+		{
+			const auto Result = RunLookReplication(NumPlayers, static_cast<ELookReplication>(Replication));
+			const auto Seconds = static_cast<double>(NumPlayers) * LookSeconds;
+			const auto BytesPerPlayer = Result.NumBits / 8.0 / Seconds;
+			const auto BytesPerClient = BytesPerPlayer * (NumPlayers - 1);
+			std::printf("%-7zu %-26s %10.1f %8.1f %12.1f %12.1f %13.1f %10.3f %9.3f\n", NumPlayers, Names[Replication],
+				Result.NumUpdates / Seconds, static_cast<double>(Result.NumBits) / std::max<uint64_t>(Result.NumUpdates, 1), BytesPerPlayer,
+				BytesPerClient, BytesPerClient * NumPlayers / 1024.0, Result.ErrorSum / Result.NumSamples, Result.MaxError);
+
+			if (Replication == LookReplication_Rotator)
+			{
+				RotatorBytes = BytesPerPlayer;
+			}
+			else if (Replication == LookReplication_Quantized)
+			{
+				bPassed = bPassed && BytesPerPlayer < RotatorBytes && Result.MaxError <= LookThreshold + 0.001f;
+			}
+		}
+	}
+
+	if (!bPassed)
+	{
+		std::printf("FReplicatedLookRotation isn't smaller than the FRotator, or is off by more than the threshold\n");
+	}
+
+	return (bPassed ? 0 : 1);
+}
@@ -0,0 +1,137 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGunBenchmarkCommon.h"
+#include "SD5BunnyGunMovementBatch.h"
+
+#include <algorithm>
+
+using namespace SD5BunnyGunBenchmark;
+using namespace SD5BunnyGunMovementMath;
+
+static void SetBenchBatchMode(FMovementBatch& Batch, size_t Index, bool bOnGround, const FBenchTuning& Tuning)
+{
+	Batch.Flags[Index] = (bOnGround ? (MovementBatchFlag_Walking | MovementBatchFlag_ApplyFriction) : MovementBatchFlag_Falling);
+	Batch.WishSpeed[Index] = Tuning.MaxWalkSpeed;
+	Batch.Acceleration[Index] = (bOnGround ? Tuning.MaxAcceleration : Tuning.MaxAirAcceleration);
+}
+
+// Fills a batch from the simulated characters.
+static FMovementBatch MakeBenchBatch(const std::vector<FBenchCharacter>& Characters, const FBenchTuning& Tuning)
+{
+	FMovementBatch Batch;
+	Batch.SetNum(Characters.size());
+
+	for (size_t Index = 0; Index < Characters.size(); ++Index)
+	{
+		const auto& Character = Characters[Index];
+		Batch.VelocityX[Index] = Character.Velocity.X;
+		Batch.VelocityY[Index] = Character.Velocity.Y;
+		Batch.VelocityZ[Index] = Character.Velocity.Z;
+		Batch.WishDirectionX[Index] = Character.WishDirection.X;
+		Batch.WishDirectionY[Index] = Character.WishDirection.Y;
+		Batch.WishDirectionZ[Index] = Character.WishDirection.Z;
+		Batch.Friction[Index] = Tuning.GroundFriction;
+		SetBenchBatchMode(Batch, Index, IsBenchCharacterOnGround(Character), Tuning);
+	}
+
+	return Batch;
+}
+
+// Characters grouped by the tick (modulo BenchAirTicks) they land on, so that only the characters that land or take off
+// need their movement mode updated each tick.
+static std::vector<std::vector<size_t>> MakeBenchLandingGroups(const std::vector<FBenchCharacter>& Characters)
+{
+	std::vector<std::vector<size_t>> LandingGroups(BenchAirTicks);
+	for (size_t Index = 0; Index < Characters.size(); ++Index)
+	{
+		LandingGroups[(BenchAirTicks - (Characters[Index].Tick % BenchAirTicks)) % BenchAirTicks].push_back(Index);
+	}
+
+	return LandingGroups;
+}
+
+// Updates the movement mode of the characters that land or take off this tick.
+static void UpdateBenchBatchModes(FMovementBatch& Batch, const std::vector<std::vector<size_t>>& LandingGroups, uint32_t Tick, const FBenchTuning& Tuning)
+{
+	for (const auto Index : LandingGroups[(Tick + BenchAirTicks - 1) % BenchAirTicks])
+	{
+		SetBenchBatchMode(Batch, Index, false, Tuning);
+	}
+
+	for (const auto Index : LandingGroups[Tick % BenchAirTicks])
+	{
+		SetBenchBatchMode(Batch, Index, true, Tuning);
+	}
+}
+
+template <typename SolveFunctionType>
+static double RunBenchBatch(FMovementBatch& Batch, const std::vector<FBenchCharacter>& Characters, uint32_t Ticks, const FBenchTuning& Tuning, SolveFunctionType SolveFunction)
+{
+	FMovementBatchParams Params;
+	Params.DeltaTime = BenchDeltaTime;
+	Params.StopSpeed = Tuning.StopSpeed;
+	Params.MaxFallAirSpeed = Tuning.MaxFallAirSpeed;
+	Params.bUseEnforcedMaxSpeed = true;
+	Params.EnforcedMaxSpeed = Tuning.EnforcedMaxSpeed;
+
+	const auto LandingGroups = MakeBenchLandingGroups(Characters);
+
+	const FBenchTimer Timer;
+	for (uint32_t Tick = 0; Tick < Ticks; ++Tick)
+	{
+		UpdateBenchBatchModes(Batch, LandingGroups, Tick, Tuning);
+		SolveFunction(Batch, Params);
+	}
+
+	return Timer.GetElapsedSeconds();
+}
+
+// Largest difference between the velocities of two batches, relative to the speed of the character (or 1 cm/s).
+static float GetMaxRelativeError(const FMovementBatch& A, const FMovementBatch& B)
+{
+	auto MaxError = 0.0f;
+	for (size_t Index = 0; Index < A.Num(); ++Index)
+	{
+		const auto Speed = std::sqrt(A.VelocityX[Index] * A.VelocityX[Index] + A.VelocityY[Index] * A.VelocityY[Index] + A.VelocityZ[Index] * A.VelocityZ[Index]);
+		const auto Error = std::max(std::max(std::abs(A.VelocityX[Index] - B.VelocityX[Index]), std::abs(A.VelocityY[Index] - B.VelocityY[Index])), std::abs(A.VelocityZ[Index] - B.VelocityZ[Index]));
+		MaxError = std::max(MaxError, Error / std::max(1.0f, Speed));
+	}
+
+	return MaxError;
+}
+
+// Compares the scalar & SIMD batch solvers for 1, 1k and 100k simulated characters.
+// Returns non-zero if the SIMD results are outside of MovementBatchTolerance.
+int main()
+{
+	const FBenchTuning Tuning;
+	auto bWithinTolerance = true;
+
+	std::printf("SIMD kernel: %s, tolerance: %g\n", GetMovementBatchKernelName(), MovementBatchTolerance);
+	PrintBenchHeader("Bunny Gun movement batch (SoA)");
+	for (const auto NumCharacters : BenchCharacterCounts)
+	{
+		const auto Characters = MakeBenchCharacters(NumCharacters);
+		const auto Ticks = GetBenchTicks(NumCharacters);
+
+		auto ScalarBatch = MakeBenchBatch(Characters, Tuning);
+		const auto ScalarSeconds = RunBenchBatch(ScalarBatch, Characters, Ticks, Tuning, SolveMovementBatchScalar);
+		PrintBenchResult("batch scalar", NumCharacters, Ticks, ScalarSeconds);
+
+		auto SimdBatch = MakeBenchBatch(Characters, Tuning);
+		const auto SimdSeconds = RunBenchBatch(SimdBatch, Characters, Ticks, Tuning, SolveMovementBatch);
+		PrintBenchResult("batch simd", NumCharacters, Ticks, SimdSeconds);
+
+		const auto MaxError = GetMaxRelativeError(ScalarBatch, SimdBatch);
+		std::printf("  speedup %.2fx, max relative error %g\n", ScalarSeconds / SimdSeconds, MaxError);
+		bWithinTolerance = bWithinTolerance && MaxError <= MovementBatchTolerance;
+	}
+
+	if (!bWithinTolerance)
+	{
+		std::printf("SIMD results are outside of the documented tolerance!\n");
+		return 1;
+	}
+
+	return 0;
+}
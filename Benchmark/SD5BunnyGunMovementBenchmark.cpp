@@ -0,0 +1,33 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGunBenchmarkCommon.h"
+
+using namespace SD5BunnyGunBenchmark;
+
+// Times the scalar movement math for 1, 1k and 100k simulated bunnyhopping characters.
+int main()
+{
+	const FBenchTuning Tuning;
+
+	PrintBenchHeader("Bunny Gun movement math (scalar)");
+	for (const auto NumCharacters : BenchCharacterCounts)
+	{
+		auto Characters = MakeBenchCharacters(NumCharacters);
+		const auto Ticks = GetBenchTicks(NumCharacters);
+
+		const FBenchTimer Timer;
+		for (uint32_t Tick = 0; Tick < Ticks; ++Tick)
+		{
+			for (auto& Character : Characters)
+			{
+				UpdateBenchCharacter(Character, Tuning);
+			}
+		}
+		const auto Seconds = Timer.GetElapsedSeconds();
+
+		PrintBenchResult("scalar", NumCharacters, Ticks, Seconds);
+		std::printf("  (checksum %.3f)\n", GetBenchChecksum(Characters));
+	}
+
+	return 0;
+}
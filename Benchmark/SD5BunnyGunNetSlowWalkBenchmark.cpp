@@ -0,0 +1,284 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGunBenchmarkCommon.h"
+
+#include <deque>
+
+using namespace SD5BunnyGunBenchmark;
+namespace Math = SD5BunnyGunMovementMath;
+
+// One-way latency of the simulated connection, in ticks (50 ms at 60 Hz).
+static const uint32_t NetLatencyTicks = 3;
+
+// Number of ticks simulated for every loss rate (10 minutes at 60 Hz).
+static const uint32_t NetSimTicks = 60 * 60 * 10;
+
+// Position error (squared) above which the server corrects the client, like MAXPOSITIONERRORSQUARED.
+static const float NetMaxPositionErrorSquared = 3.0f;
+
+// Default SlowWalkingMaxSpeedMultiplier of USD5BunnyGunCharacterMovement.
+static const float NetSlowWalkingMaxSpeedMultiplier = 0.3f;
+
+// Packet loss rates that are simulated.
+static const float NetLossRates[] = { 0.0f, 0.01f, 0.05f, 0.1f, 0.2f };
+
+// How the slow walking state gets to the server.
+enum ENetSlowWalkSync
+{
+	// ServerSetSlowWalking() reliable RPC on every press & release.
+	NetSlowWalkSync_ReliableRpc,
+
+	// FSavedMove_SD5BunnyGun::FLAG_SlowWalking in the flags of every move.
+	NetSlowWalkSync_MoveFlags
+};
+
+// Input of the client for a single tick.
+struct FNetInput
+{
+	FBenchVector WishDirection;
+	bool bSlowWalking;
+};
+
+// Everything that is random about a run, shared by both ways of syncing so that they see the exact same conditions.
+struct FNetConditions
+{
+	std::vector<FNetInput> Inputs;
+	std::vector<bool> bMovePacketLost;
+	std::vector<bool> bCorrectionLost;
+	std::vector<bool> bRpcResendLost;
+};
+
+struct FNetState
+{
+	FBenchVector Location;
+	FBenchVector Velocity;
+};
+
+// A move saved by the client for replaying after a correction.
+struct FNetSavedMove
+{
+	uint32_t Tick;
+	bool bSlowWalking;
+	FBenchVector Location;
+};
+
+// A correction (ClientAdjustPosition()) on its way to the client.
+struct FNetCorrection
+{
+	uint32_t ArrivalTick;
+	uint32_t MoveTick;
+	FNetState State;
+};
+
+struct FNetResult
+{
+	uint32_t ReliableSends;
+	uint32_t Corrections;
+};
+
+// Walks the character on a flat floor for a tick.
+static void StepNetMovement(FNetState& State, const FNetInput& Input, bool bSlowWalking, const FBenchTuning& Tuning)
+{
+	const auto WishSpeed = Tuning.MaxWalkSpeed * (bSlowWalking ? NetSlowWalkingMaxSpeedMultiplier : 1.0f);
+	Math::ApplyFriction(State.Velocity, BenchDeltaTime, Tuning.GroundFriction, 1.0f, Tuning.StopSpeed);
+	Math::ApplyAcceleration(State.Velocity, BenchDeltaTime, 1.0f, Input.WishDirection, WishSpeed, Tuning.MaxAcceleration);
+	State.Location = FBenchVector(State.Location.X + State.Velocity.X * BenchDeltaTime, State.Location.Y + State.Velocity.Y * BenchDeltaTime, 0.0f);
+}
+
+// Running around in circles, pressing & releasing slow walk every 0.25 - 1.5 seconds.
+static FNetConditions MakeNetConditions(float LossRate)
+{
+	FNetConditions Conditions;
+	auto InputSeed = 0x5D5u;
+	auto LossSeed = 0xB6u;
+	auto bSlowWalking = false;
+	uint32_t NextToggleTick = 60;
+
+	for (uint32_t Tick = 0; Tick < NetSimTicks; ++Tick)
+	{
+		if (Tick == NextToggleTick)
+		{
+			bSlowWalking = !bSlowWalking;
+			NextToggleTick = Tick + 15 + static_cast<uint32_t>(BenchRandom(InputSeed) * 75.0f);
+		}
+
+		const auto Yaw = Tick * 0.01f;
+		FNetInput Input;
+		Input.WishDirection = FBenchVector(std::cos(Yaw), std::sin(Yaw), 0.0f);
+		Input.bSlowWalking = bSlowWalking;
+		Conditions.Inputs.push_back(Input);
+
+		Conditions.bMovePacketLost.push_back(BenchRandom(LossSeed) < LossRate);
+		Conditions.bCorrectionLost.push_back(BenchRandom(LossSeed) < LossRate);
+		Conditions.bRpcResendLost.push_back(BenchRandom(LossSeed) < LossRate);
+	}
+
+	return Conditions;
+}
+
+// Works out when every ServerSetSlowWalking() RPC reaches the server. Returns the tick each input tick's RPC arrives at
+// (0 if there was no RPC), and counts the reliable sends including resends.
+static std::vector<uint32_t> SimulateReliableRpcs(const FNetConditions& Conditions, uint32_t& OutReliableSends)
+{
+	std::vector<uint32_t> ArrivalTicks(NetSimTicks, 0);
+	uint32_t LastArrivalTick = 0;
+	OutReliableSends = 0;
+
+	for (uint32_t Tick = 1; Tick < NetSimTicks; ++Tick)
+	{
+		if (Conditions.Inputs[Tick].bSlowWalking == Conditions.Inputs[Tick - 1].bSlowWalking)
+		{
+			continue;
+		}
+
+		// The first send goes out in the same packet as the move of this tick. Lost sends are resent once the loss
+		// is noticed, a round trip later.
+		auto SendTick = Tick;
+		auto bLost = Conditions.bMovePacketLost[Tick];
+		++OutReliableSends;
+		while (bLost)
+		{
+			SendTick += 2 * NetLatencyTicks;
+			bLost = (SendTick < NetSimTicks && Conditions.bRpcResendLost[SendTick]);
+			++OutReliableSends;
+		}
+
+		// Reliable RPCs are handled in order, so one waits for every RPC before it.
+		LastArrivalTick = std::max(LastArrivalTick, SendTick + NetLatencyTicks);
+		if (LastArrivalTick < NetSimTicks)
+		{
+			ArrivalTicks[LastArrivalTick] = Tick;
+		}
+	}
+
+	return ArrivalTicks;
+}
+
+// Simulates a client moving with prediction & a server checking its moves over a lossy connection.
+static FNetResult SimulateNetSlowWalk(const FNetConditions& Conditions, ENetSlowWalkSync Sync, const FBenchTuning& Tuning)
+{
+	FNetResult Result;
+	const auto RpcArrivalTicks = SimulateReliableRpcs(Conditions, Result.ReliableSends);
+	Result.ReliableSends = (Sync == NetSlowWalkSync_ReliableRpc ? Result.ReliableSends : 0);
+	Result.Corrections = 0;
+
+	FNetState ClientState = FNetState(), ServerState = FNetState();
+	std::deque<FNetSavedMove> SavedMoves;
+	std::deque<FNetCorrection> Corrections;
+	auto bServerSlowWalking = false;
+	uint32_t ServerMoveTick = 0;
+
+	for (uint32_t Tick = 1; Tick < NetSimTicks; ++Tick)
+	{
+		// Client: apply a correction and replay the moves made since.
+		while (!Corrections.empty() && Corrections.front().ArrivalTick <= Tick)
+		{
+			const auto Correction = Corrections.front();
+			Corrections.pop_front();
+
+			while (!SavedMoves.empty() && SavedMoves.front().Tick <= Correction.MoveTick)
+			{
+				SavedMoves.pop_front();
+			}
+
+			ClientState = Correction.State;
+			for (auto& Move : SavedMoves)
+			{
+				StepNetMovement(ClientState, Conditions.Inputs[Move.Tick], Move.bSlowWalking, Tuning);
+				Move.Location = ClientState.Location;
+			}
+		}
+
+		// Client: make & send this tick's move.
+		const auto& Input = Conditions.Inputs[Tick];
+		StepNetMovement(ClientState, Input, Input.bSlowWalking, Tuning);
+		FNetSavedMove NewMove;
+		NewMove.Tick = Tick;
+		NewMove.bSlowWalking = Input.bSlowWalking;
+		NewMove.Location = ClientState.Location;
+		SavedMoves.push_back(NewMove);
+
+		if (Tick < NetLatencyTicks + 1)
+		{
+			continue;
+		}
+
+		// Server: RPCs arriving now are handled before the moves in the same packet.
+		if (Sync == NetSlowWalkSync_ReliableRpc && RpcArrivalTicks[Tick] != 0)
+		{
+			bServerSlowWalking = Conditions.Inputs[RpcArrivalTicks[Tick]].bSlowWalking;
+		}
+
+		// Server: every packet carries the newest two moves (like ServerMoveDual()). If both of a move's packets
+		// were lost, its time is simulated with the input of the next move that arrives.
+		const auto SentTick = Tick - NetLatencyTicks;
+		if (Conditions.bMovePacketLost[SentTick])
+		{
+			continue;
+		}
+
+		for (auto MoveTick = SentTick - 1; MoveTick <= SentTick; ++MoveTick)
+		{
+			if (MoveTick <= ServerMoveTick)
+			{
+				continue;
+			}
+
+			const auto& MoveInput = Conditions.Inputs[MoveTick];
+			const auto bSlowWalking = (Sync == NetSlowWalkSync_MoveFlags ? MoveInput.bSlowWalking : bServerSlowWalking);
+			for (; ServerMoveTick < MoveTick; ++ServerMoveTick)
+			{
+				StepNetMovement(ServerState, MoveInput, bSlowWalking, Tuning);
+			}
+
+			// The location the client reported for this move, as it was when the move was sent.
+			auto ClientLocation = ServerState.Location;
+			for (const auto& Move : SavedMoves)
+			{
+				ClientLocation = (Move.Tick == MoveTick ? Move.Location : ClientLocation);
+			}
+
+			const auto Error = FBenchVector(ServerState.Location.X - ClientLocation.X, ServerState.Location.Y - ClientLocation.Y, 0.0f);
+			if (Math::SizeSquared(Error) > NetMaxPositionErrorSquared)
+			{
+				++Result.Corrections;
+				if (!Conditions.bCorrectionLost[Tick])
+				{
+					FNetCorrection Correction;
+					Correction.ArrivalTick = Tick + NetLatencyTicks;
+					Correction.MoveTick = MoveTick;
+					Correction.State = ServerState;
+					Corrections.push_back(Correction);
+				}
+			}
+		}
+
+		// Moves older than a round trip have been checked by the server.
+		while (SavedMoves.size() > 4 * NetLatencyTicks + 2)
+		{
+			SavedMoves.pop_front();
+		}
+	}
+
+	return Result;
+}
+
+// Compares sending slow walking with a reliable RPC against sending it in the flags of every move, over a simulated
+// connection with packet loss. Counts the reliable sends (including resends) and the corrections the server sends.
+int main()
+{
+	const FBenchTuning Tuning;
+
+	std::printf("Slow walk sync over %u ticks at %u ms latency\n", NetSimTicks, static_cast<uint32_t>(NetLatencyTicks * BenchDeltaTime * 1000.0f + 0.5f));
+	std::printf("%-10s %18s %18s %18s %18s\n", "loss", "RPC reliable sends", "flag reliable sends", "RPC corrections", "flag corrections");
+	for (const auto LossRate : NetLossRates)
+	{
+		const auto Conditions = MakeNetConditions(LossRate);
+		const auto RpcResult = SimulateNetSlowWalk(Conditions, NetSlowWalkSync_ReliableRpc, Tuning);
+		const auto FlagResult = SimulateNetSlowWalk(Conditions, NetSlowWalkSync_MoveFlags, Tuning);
+
+		std::printf("%9.0f%% %18u %18u %18u %18u\n", LossRate * 100.0f, RpcResult.ReliableSends, FlagResult.ReliableSends, RpcResult.Corrections, FlagResult.Corrections);
+	}
+
+	return 0;
+}
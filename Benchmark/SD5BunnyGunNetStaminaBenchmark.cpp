@@ -0,0 +1,292 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGunBenchmarkCommon.h"
+
+#include <deque>
+
+using namespace SD5BunnyGunBenchmark;
+namespace Math = SD5BunnyGunMovementMath;
+
+// One-way latency of the simulated connection, in ticks (50 ms at 60 Hz).
+static const uint32_t NetLatencyTicks = 3;
+
+// The server ticks once every this many client ticks (30 Hz).
+static const uint32_t NetServerFrameTicks = 2;
+
+// Number of ticks simulated for every loss rate (10 minutes at 60 Hz).
+static const uint32_t NetSimTicks = 60 * 60 * 10;
+
+// Position error (squared) above which the server corrects the client, like MAXPOSITIONERRORSQUARED.
+static const float NetMaxPositionErrorSquared = 3.0f;
+
+// Default gravity of the engine (cm/s^2).
+static const float NetGravityZ = -980.0f;
+
+// Packet loss rates that are simulated.
+static const float NetLossRates[] = { 0.0f, 0.01f, 0.05f, 0.1f };
+
+// Predicted stamina may cause at most this many more corrections than having stamina disabled (relative & absolute).
+static const float NetStaminaCorrectionTolerance = 0.1f;
+static const uint32_t NetStaminaCorrectionSlack = 5;
+
+// How stamina is handled.
+enum ENetStaminaMode
+{
+	// Stamina is disabled.
+	NetStaminaMode_Off,
+
+	// Stamina is updated every frame by both sides & not restored when replaying (before it was predicted).
+	NetStaminaMode_Unpredicted,
+
+	// Stamina is updated by every move, restored when replaying & sent with corrections.
+	NetStaminaMode_Predicted
+};
+
+// Input of the client for a single tick.
+struct FNetInput
+{
+	FBenchVector WishDirection;
+	bool bJump;
+};
+
+// Everything that is random about a run, shared by every mode so that they see the exact same conditions.
+struct FNetConditions
+{
+	std::vector<FNetInput> Inputs;
+	std::vector<bool> bMovePacketLost;
+	std::vector<bool> bCorrectionLost;
+};
+
+struct FNetState
+{
+	FBenchVector Location;
+	FBenchVector Velocity;
+	float Stamina;
+	bool bFalling;
+	bool bWasFalling;
+
+	FNetState() : Stamina(0.0f), bFalling(false), bWasFalling(false) { }
+};
+
+// A move saved by the client for replaying after a correction.
+struct FNetSavedMove
+{
+	uint32_t Tick;
+	FBenchVector Location;
+};
+
+// A correction (ClientAdjustPosition() & ClientAdjustStamina()) on its way to the client.
+struct FNetCorrection
+{
+	uint32_t ArrivalTick;
+	uint32_t MoveTick;
+	FNetState State;
+};
+
+// Performs a move of a strafe-jumping character on a flat floor, like the replay benchmark.
+static void StepNetMovement(FNetState& State, const FNetInput& Input, ENetStaminaMode Mode, bool bUpdateStamina, const FBenchTuning& Tuning)
+{
+	const auto bEnableStamina = (Mode != NetStaminaMode_Off);
+	if (bEnableStamina && bUpdateStamina)
+	{
+		State.Stamina = Math::DecayStamina(State.Stamina, BenchDeltaTime);
+	}
+
+	if (!State.bFalling && Input.bJump)
+	{
+		State.Velocity.Z = Tuning.Trimping.JumpZVelocity;
+		if (bEnableStamina)
+		{
+			State.Velocity.Z *= Math::GetStaminaJumpVelocityMultiplier(State.Stamina, Tuning.Stamina);
+			State.Stamina = Math::GetStaminaAfterJump(Tuning.Stamina);
+		}
+		State.bFalling = true;
+	}
+
+	const auto VerticalVelocity = State.Velocity.Z;
+	State.Velocity.Z = 0.0f;
+	if (!State.bFalling && !State.bWasFalling)
+	{
+		if (bEnableStamina && State.Stamina > 0.0f)
+		{
+			const auto Multiplier = Math::GetStaminaWalkSpeedMultiplier(State.Stamina, BenchDeltaTime, Tuning.Stamina);
+			State.Velocity.X *= Multiplier;
+			State.Velocity.Y *= Multiplier;
+		}
+
+		Math::ApplyFriction(State.Velocity, BenchDeltaTime, Tuning.GroundFriction, 1.0f, Tuning.StopSpeed);
+		Math::ApplyAcceleration(State.Velocity, BenchDeltaTime, 1.0f, Input.WishDirection, Tuning.MaxWalkSpeed, Tuning.MaxAcceleration);
+	}
+	else
+	{
+		Math::ApplyAirAcceleration(State.Velocity, BenchDeltaTime, 1.0f, Input.WishDirection, Tuning.MaxWalkSpeed, Tuning.MaxFallAirSpeed, Tuning.MaxAirAcceleration);
+	}
+	State.Velocity = Math::GetClampedToMaxSizePrecise(State.Velocity, Tuning.EnforcedMaxSpeed);
+	State.Velocity.Z = VerticalVelocity;
+	State.bWasFalling = State.bFalling;
+
+	if (State.bFalling)
+	{
+		State.Velocity.Z += NetGravityZ * BenchDeltaTime;
+	}
+	State.Location = FBenchVector(State.Location.X + State.Velocity.X * BenchDeltaTime, State.Location.Y + State.Velocity.Y * BenchDeltaTime, State.Location.Z + State.Velocity.Z * BenchDeltaTime);
+	if (State.bFalling && State.Location.Z <= 0.0f)
+	{
+		State.Location.Z = 0.0f;
+		State.Velocity.Z = 0.0f;
+		State.bFalling = false;
+	}
+}
+
+// Strafe-jumping with autohop, letting go of jump for a while every few seconds.
+static FNetConditions MakeNetConditions(float LossRate)
+{
+	FNetConditions Conditions;
+	auto LossSeed = 0xB6u;
+
+	for (uint32_t Tick = 0; Tick < NetSimTicks; ++Tick)
+	{
+		const auto Side = ((Tick / 45) % 2 == 0 ? 1.0f : -1.0f);
+		const auto Yaw = Tick * 0.02f * Side;
+
+		FNetInput Input;
+		Input.WishDirection = FBenchVector(std::cos(Yaw), std::sin(Yaw), 0.0f);
+		Input.bJump = (Tick % 400) >= 60;
+		Conditions.Inputs.push_back(Input);
+
+		Conditions.bMovePacketLost.push_back(BenchRandom(LossSeed) < LossRate);
+		Conditions.bCorrectionLost.push_back(BenchRandom(LossSeed) < LossRate);
+	}
+
+	return Conditions;
+}
+
+// Simulates a client moving with prediction & a server checking its moves over a lossy connection. Returns the number
+// of corrections the server sent.
+static uint32_t SimulateNetStamina(const FNetConditions& Conditions, ENetStaminaMode Mode, const FBenchTuning& Tuning)
+{
+	const auto bPredicted = (Mode == NetStaminaMode_Predicted);
+	uint32_t NumCorrections = 0;
+
+	FNetState ClientState, ServerState;
+	std::deque<FNetSavedMove> SavedMoves;
+	std::deque<FNetCorrection> Corrections;
+	uint32_t ServerMoveTick = 0;
+
+	for (uint32_t Tick = 1; Tick < NetSimTicks; ++Tick)
+	{
+		// Client: apply a correction and replay the moves made since.
+		while (!Corrections.empty() && Corrections.front().ArrivalTick <= Tick)
+		{
+			const auto Correction = Corrections.front();
+			Corrections.pop_front();
+
+			while (!SavedMoves.empty() && SavedMoves.front().Tick <= Correction.MoveTick)
+			{
+				SavedMoves.pop_front();
+			}
+
+			// Without prediction, the client keeps its current stamina & replays without updating it.
+			const auto ClientStamina = ClientState.Stamina;
+			ClientState = Correction.State;
+			ClientState.Stamina = (bPredicted ? Correction.State.Stamina : ClientStamina);
+			for (auto& Move : SavedMoves)
+			{
+				StepNetMovement(ClientState, Conditions.Inputs[Move.Tick], Mode, bPredicted, Tuning);
+				Move.Location = ClientState.Location;
+			}
+		}
+
+		// Client: make & send this tick's move. Without prediction, stamina is updated by the frame instead.
+		FNetSavedMove NewMove;
+		NewMove.Tick = Tick;
+		StepNetMovement(ClientState, Conditions.Inputs[Tick], Mode, true, Tuning);
+		NewMove.Location = ClientState.Location;
+		SavedMoves.push_back(NewMove);
+
+		if (Tick < NetLatencyTicks + 1)
+		{
+			continue;
+		}
+
+		// Server: without prediction, stamina is updated once per server frame, whenever the moves arrive.
+		if (Mode == NetStaminaMode_Unpredicted && Tick % NetServerFrameTicks == 0)
+		{
+			ServerState.Stamina = Math::DecayStamina(ServerState.Stamina, NetServerFrameTicks * BenchDeltaTime);
+		}
+
+		// Server: every packet carries the newest two moves (like ServerMoveDual()). If both of a move's packets
+		// were lost, its time is simulated with the input of the next move that arrives.
+		const auto SentTick = Tick - NetLatencyTicks;
+		if (Conditions.bMovePacketLost[SentTick])
+		{
+			continue;
+		}
+
+		for (auto MoveTick = SentTick - 1; MoveTick <= SentTick; ++MoveTick)
+		{
+			if (MoveTick <= ServerMoveTick)
+			{
+				continue;
+			}
+
+			for (; ServerMoveTick < MoveTick; ++ServerMoveTick)
+			{
+				StepNetMovement(ServerState, Conditions.Inputs[MoveTick], Mode, bPredicted, Tuning);
+			}
+
+			// The location the client reported for this move, as it was when the move was sent.
+			auto ClientLocation = ServerState.Location;
+			for (const auto& Move : SavedMoves)
+			{
+				ClientLocation = (Move.Tick == MoveTick ? Move.Location : ClientLocation);
+			}
+
+			const auto Error = FBenchVector(ServerState.Location.X - ClientLocation.X, ServerState.Location.Y - ClientLocation.Y, ServerState.Location.Z - ClientLocation.Z);
+			if (Math::SizeSquared(Error) > NetMaxPositionErrorSquared)
+			{
+				++NumCorrections;
+				if (!Conditions.bCorrectionLost[Tick])
+				{
+					FNetCorrection Correction;
+					Correction.ArrivalTick = Tick + NetLatencyTicks;
+					Correction.MoveTick = MoveTick;
+					Correction.State = ServerState;
+					Corrections.push_back(Correction);
+				}
+			}
+		}
+
+		// Moves older than a round trip have been checked by the server.
+		while (SavedMoves.size() > 4 * NetLatencyTicks + 2)
+		{
+			SavedMoves.pop_front();
+		}
+	}
+
+	return NumCorrections;
+}
+
+// Checks that predicted stamina doesn't cause more corrections than having stamina disabled, over a simulated connection
+// with packet loss, and shows how many corrections stamina caused before it was predicted. Fails if it does.
+int main()
+{
+	const FBenchTuning Tuning;
+	auto bPassed = true;
+
+	std::printf("Corrections over %u ticks at %u ms latency\n", NetSimTicks, static_cast<uint32_t>(NetLatencyTicks * BenchDeltaTime * 1000.0f + 0.5f));
+	std::printf("%-10s %16s %16s %16s\n", "loss", "stamina off", "unpredicted", "predicted");
+	for (const auto LossRate : NetLossRates)
+	{
+		const auto Conditions = MakeNetConditions(LossRate);
+		const auto OffCorrections = SimulateNetStamina(Conditions, NetStaminaMode_Off, Tuning);
+		const auto UnpredictedCorrections = SimulateNetStamina(Conditions, NetStaminaMode_Unpredicted, Tuning);
+		const auto PredictedCorrections = SimulateNetStamina(Conditions, NetStaminaMode_Predicted, Tuning);
+
+		const auto bLossPassed = PredictedCorrections <= OffCorrections * (1.0f + NetStaminaCorrectionTolerance) + NetStaminaCorrectionSlack;
+		bPassed = bPassed && bLossPassed;
+		std::printf("%9.0f%% %16u %16u %16u %s\n", LossRate * 100.0f, OffCorrections, UnpredictedCorrections, PredictedCorrections, (bLossPassed ? "ok" : "TOO MANY CORRECTIONS"));
+	}
+
+	return (bPassed ? 0 : 1);
+}
@@ -0,0 +1,257 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGunBenchmarkCommon.h"
+
+#include <algorithm>
+
+using namespace SD5BunnyGunBenchmark;
+
+// Client counts the server is simulated at. Every client views from its own character.
+static const size_t RelevancyClientCounts[] = { 64, 128, 200 };
+
+// Side of the square arena (cm) the characters bunnyhop around in.
+static const float ArenaSize = 80000.0f;
+
+// Server net ticks simulated (30 Hz, like a dedicated server), and the runs of each count (keeping the fastest).
+static const float NetTickTime = 1.0f / 30.0f;
+static const uint32_t RelevancyFrames = 900;
+static const int RelevancyRuns = 3;
+
+// Defaults of AActor: NetCullDistanceSquared, NetUpdateFrequency & NetPriority (3 for pawns).
+static const float NetCullDistance = 15000.0f;
+static const float NetUpdateFrequency = 100.0f;
+static const float NetPriority = 3.0f;
+
+// Latency of the clients (one way), used to work out where a character is when its client first sees it.
+static const float ClientLatency = 0.1f;
+
+// Distance thresholds of APawn::GetNetPriority() (the same as the engine's).
+static const float CloseProximitySquared = 500.0f * 500.0f;
+static const float NearSightThresholdSquared = 2000.0f * 2000.0f;
+static const float MedSightThresholdSquared = 3162.0f * 3162.0f;
+static const float FarSightThresholdSquared = 8000.0f * 8000.0f;
+
+// A bunnyhopping character as seen by the server.
+struct FRelevancyCharacter
+{
+	FBenchVector Location;
+	FBenchVector Velocity;
+	float TurnRate;
+};
+
+// What the relevancy of a run came to.
+struct FRelevancyResult
+{
+	double NsPerFrame;
+	double RelevantPairsPerFrame;
+	double PrioritySum;
+
+	// Pairs that became relevant while the viewer & character were closing in, and how many of them the client only
+	// saw inside NetCullDistance (after the latency & up to a net update late).
+	uint64_t NumBecameRelevant;
+	uint64_t NumLate;
+	float WorstLateDepth;
+};
+
+static float DistSquared(const FBenchVector& A, const FBenchVector& B)
+{
+	const auto X = A.X - B.X;
+	const auto Y = A.Y - B.Y;
+	const auto Z = A.Z - B.Z;
+	return X * X + Y * Y + Z * Z;
+}
+
+// Creates the characters spread over the arena, bunnyhopping at 600 cm/s up to the enforced max speed.
+static std::vector<FRelevancyCharacter> MakeRelevancyCharacters(size_t NumCharacters, const FBenchTuning& Tuning)
+{
+	std::vector<FRelevancyCharacter> Characters(NumCharacters);
+
+	auto Seed = 0x5D5u;
+	for (auto& Character : Characters)
+	{
+		const auto Yaw = BenchRandom(Seed) * 2.0f * SD5BunnyGunMovementMath::Pi;
+		const auto Speed = 600.0f + BenchRandom(Seed) * (Tuning.EnforcedMaxSpeed - 600.0f);
+		Character.Location = FBenchVector(BenchRandom(Seed) * ArenaSize, BenchRandom(Seed) * ArenaSize, BenchRandom(Seed) * 2000.0f);
+		Character.Velocity = FBenchVector(std::cos(Yaw) * Speed, std::sin(Yaw) * Speed, 0.0f);
+		Character.TurnRate = (BenchRandom(Seed) - 0.5f) * 1.5f;
+	}
+
+	return Characters;
+}
+
+// Moves the characters over a net tick: air-strafing turns, bouncing off the walls of the arena.
+static void MoveRelevancyCharacters(std::vector<FRelevancyCharacter>& Characters)
+{
+	for (auto& Character : Characters)
+	{
+		const auto Cos = std::cos(Character.TurnRate * NetTickTime);
+		const auto Sin = std::sin(Character.TurnRate * NetTickTime);
+		Character.Velocity = FBenchVector(Character.Velocity.X * Cos - Character.Velocity.Y * Sin, Character.Velocity.X * Sin + Character.Velocity.Y * Cos, 0.0f);
+		Character.Location.X += Character.Velocity.X * NetTickTime;
+		Character.Location.Y += Character.Velocity.Y * NetTickTime;
+
+		if (Character.Location.X < 0.0f || Character.Location.X > ArenaSize)
+		{
+			Character.Velocity.X = -Character.Velocity.X;
+			Character.Location.X = std::min(std::max(Character.Location.X, 0.0f), ArenaSize);
+		}
+		if (Character.Location.Y < 0.0f || Character.Location.Y > ArenaSize)
+		{
+			Character.Velocity.Y = -Character.Velocity.Y;
+			Character.Location.Y = std::min(std::max(Character.Location.Y, 0.0f), ArenaSize);
+		}
+	}
+}
+
+// Mirrors APawn::GetNetPriority() for a character that isn't the viewer's own.
+static float GetDefaultNetPriority(const FRelevancyCharacter& Character, const FBenchVector& ViewPos, const FBenchVector& ViewDir)
+{
+	auto Time = NetTickTime;
+	const FBenchVector Dir(Character.Location.X - ViewPos.X, Character.Location.Y - ViewPos.Y, Character.Location.Z - ViewPos.Z);
+	const auto DistSq = Dir.X * Dir.X + Dir.Y * Dir.Y + Dir.Z * Dir.Z;
+	const auto Dot = ViewDir.X * Dir.X + ViewDir.Y * Dir.Y + ViewDir.Z * Dir.Z;
+
+	if (Dot < 0.0f)
+	{
+		if (DistSq > NearSightThresholdSquared)
+		{
+			Time *= 0.2f;
+		}
+		else if (DistSq > CloseProximitySquared)
+		{
+			Time *= 0.4f;
+		}
+	}
+	else if (DistSq < FarSightThresholdSquared && Dot * Dot > 0.5f * DistSq)
+	{
+		Time *= 2.0f;
+	}
+	else if (DistSq > MedSightThresholdSquared)
+	{
+		Time *= 0.4f;
+	}
+
+	return NetPriority * Time;
+}
+
+// Simulates RelevancyFrames net ticks of NumClients clients, working out the relevancy & priority of every character for
+// every connection like UNetDriver::ServerReplicateActors() does, with the default NetCullDistanceSquared.
+static FRelevancyResult RunRelevancy(size_t NumClients, const FBenchTuning& Tuning)
+{
+	FRelevancyResult Best = {};
+	Best.NsPerFrame = -1.0;
+
+	for (auto Run = 0; Run < RelevancyRuns; ++Run)
+	{
+		auto Characters = MakeRelevancyCharacters(NumClients, Tuning);
+		std::vector<uint8_t> WasRelevant(NumClients * NumClients, 0);
+		std::vector<uint8_t> IsRelevant(NumClients * NumClients, 0);
+		std::vector<float> Priorities(NumClients * NumClients, 0.0f);
+
+		FRelevancyResult Result = {};
+		double TotalNs = 0.0;
+		uint64_t NumRelevantPairs = 0;
+
+		for (uint32_t Frame = 0; Frame < RelevancyFrames; ++Frame)
+		{
+			MoveRelevancyCharacters(Characters);
+
+			const auto StartTime = std::chrono::steady_clock::now();
+
+			for (size_t ViewerIndex = 0; ViewerIndex < NumClients; ++ViewerIndex)
+			{
+				const auto& Viewer = Characters[ViewerIndex];
+				const auto ViewSpeed = std::sqrt(Viewer.Velocity.X * Viewer.Velocity.X + Viewer.Velocity.Y * Viewer.Velocity.Y);
+				const FBenchVector ViewDir(Viewer.Velocity.X / ViewSpeed, Viewer.Velocity.Y / ViewSpeed, 0.0f);
+
+				for (size_t Index = 0; Index < NumClients; ++Index)
+				{
+					// The viewer's own character is always relevant (& isn't a pair being measured).
+					if (Index == ViewerIndex)
+					{
+						continue;
+					}
+
+					const auto& Character = Characters[Index];
+					const auto PairIndex = ViewerIndex * NumClients + Index;
+					const auto bIsRelevant = (DistSquared(Character.Location, Viewer.Location) < NetCullDistance * NetCullDistance);
+					IsRelevant[PairIndex] = (bIsRelevant ? 1 : 0);
+					Priorities[PairIndex] = (bIsRelevant ? GetDefaultNetPriority(Character, Viewer.Location, ViewDir) : 0.0f);
+				}
+			}
+			TotalNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - StartTime).count();
+
+			// Check the relevancy outside of the timing.
+			for (size_t ViewerIndex = 0; ViewerIndex < NumClients; ++ViewerIndex)
+			{
+				const auto& Viewer = Characters[ViewerIndex];
+				for (size_t Index = 0; Index < NumClients; ++Index)
+				{
+					const auto PairIndex = ViewerIndex * NumClients + Index;
+					if (Index == ViewerIndex)
+					{
+						continue;
+					}
+
+					Result.PrioritySum += Priorities[PairIndex];
+					NumRelevantPairs += IsRelevant[PairIndex];
+
+					const auto& Character = Characters[Index];
+					const auto Distance = std::sqrt(DistSquared(Character.Location, Viewer.Location));
+
+					// Where the character is by the time the client sees it, if they keep closing in.
+					if (Frame > 0 && IsRelevant[PairIndex] != 0 && WasRelevant[PairIndex] == 0)
+					{
+						const FBenchVector RelativeVelocity(Character.Velocity.X - Viewer.Velocity.X, Character.Velocity.Y - Viewer.Velocity.Y, 0.0f);
+						const auto ClosingSpeed = -((Character.Location.X - Viewer.Location.X) * RelativeVelocity.X + (Character.Location.Y - Viewer.Location.Y) * RelativeVelocity.Y) / std::max(Distance, 1.0f);
+						if (ClosingSpeed > 0.0f)
+						{
+							++Result.NumBecameRelevant;
+
+							const auto SeenDistance = Distance - ClosingSpeed * (ClientLatency + 1.0f / NetUpdateFrequency);
+							if (SeenDistance < NetCullDistance)
+							{
+								++Result.NumLate;
+								Result.WorstLateDepth = std::max(Result.WorstLateDepth, NetCullDistance - SeenDistance);
+							}
+						}
+					}
+				}
+			}
+			WasRelevant.swap(IsRelevant);
+		}
+
+		Result.NsPerFrame = TotalNs / RelevancyFrames;
+		Result.RelevantPairsPerFrame = static_cast<double>(NumRelevantPairs) / RelevancyFrames;
+		if (Best.NsPerFrame < 0.0 || Result.NsPerFrame < Best.NsPerFrame)
+		{
+			Best = Result;
+		}
+	}
+
+	return Best;
+}
+
+// Simulates a server replicating bunnyhopping characters to their clients with the default relevancy, and reports the
+// relevancy & priority time per net tick, the relevant pairs, the pairs that became relevant while closing in, and how many
+// of those the client only saw inside NetCullDistance & how far inside. This is the baseline a relevancy grid would have to
+// beat; UE 4.8 checks every actor for every connection, so the time per client grows with the client count.
+int main()
+{
+	const FBenchTuning Tuning;
+
+	std::printf("Server relevancy & priority, %u net ticks at 30 Hz, %.0f m arena, NetCullDistance %.0f m, %.0f ms latency\n",
+		RelevancyFrames, ArenaSize / 100.0f, NetCullDistance / 100.0f, ClientLatency * 1000.0f);
+	std::printf("%7s %12s %14s %14s %10s %8s %10s\n", "clients", "us/net tick", "ns/client", "relevant pairs", "closing in", "late", "worst cm");
+
+	for (const auto NumClients : RelevancyClientCounts)
+	{
+		const auto Result = RunRelevancy(NumClients, Tuning);
+		const auto NsPerClient = Result.NsPerFrame / NumClients;
+		std::printf("%7zu %12.1f %14.1f %14.1f %10llu %8llu %10.0f\n", NumClients, Result.NsPerFrame / 1000.0, NsPerClient,
+			Result.RelevantPairsPerFrame, static_cast<unsigned long long>(Result.NumBecameRelevant),
+			static_cast<unsigned long long>(Result.NumLate), Result.WorstLateDepth);
+	}
+
+	return 0;
+}
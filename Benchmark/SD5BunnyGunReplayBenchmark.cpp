@@ -0,0 +1,164 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGunBenchmarkCommon.h"
+#include "SD5BunnyGunInputRecording.h"
+
+#include <cinttypes>
+#include <fstream>
+#include <iterator>
+
+using namespace SD5BunnyGunBenchmark;
+using namespace SD5BunnyGunInputRecording;
+
+// Default gravity of the engine (cm/s^2).
+static const float BenchGravityZ = -980.0f;
+
+// Number of times the recording is replayed.
+static const int BenchReplayRuns = 3;
+
+// A minute of strafe-jumping in a circle with autohop held, with some crouch & slow walk presses thrown in.
+static FInputRecording MakeSyntheticRecording()
+{
+	FInputRecording Recording;
+	Recording.FixedDeltaTime = BenchDeltaTime;
+
+	for (auto Tick = 0; Tick < 60 * 60; ++Tick)
+	{
+		FInputState State;
+		State.MoveRight = ((Tick / 45) % 2 == 0 ? 1.0f : -1.0f);
+		State.MoveForward = ((Tick % 600) < 30 ? 1.0f : 0.0f);
+		State.bJump = (Tick % 600) >= 30;
+		State.bCrouch = (Tick % 300) > 280;
+		State.bSlowWalk = (Tick % 900) > 870;
+		State.Pitch = 0.0f;
+		State.Yaw = std::fmod(Tick * 2.0f * State.MoveRight, 360.0f);
+
+		Recording.Frames.push_back(QuantizeInputState(State));
+	}
+
+	return Recording;
+}
+
+// Replays the recording through the movement math on an infinite flat floor. Returns the trajectory hash.
+static uint64_t ReplayBenchRecording(const FInputRecording& Recording, const FBenchTuning& Tuning)
+{
+	namespace Math = SD5BunnyGunMovementMath;
+
+	const auto DeltaTime = Recording.FixedDeltaTime;
+	const auto FloorNormal = FBenchVector(0.0f, 0.0f, 1.0f);
+	auto Location = FBenchVector(Recording.StartLocation[0], Recording.StartLocation[1], 0.0f);
+	auto Velocity = FBenchVector();
+	auto Stamina = 0.0f;
+	auto bFalling = false;
+	auto bWasFalling = false;
+	auto Hash = TrajectoryHashSeed;
+
+	for (const auto& Frame : Recording.Frames)
+	{
+		const auto State = DequantizeInputFrame(Frame);
+		const auto YawRadians = State.Yaw * (Math::Pi / 180.0f);
+		const auto Forward = FBenchVector(std::cos(YawRadians), std::sin(YawRadians), 0.0f);
+		const auto Right = FBenchVector(-Forward.Y, Forward.X, 0.0f);
+
+		// ScaleInputAcceleration(): input is clamped to a length of 1 and scaled by the max accel of the movement mode.
+		const auto Input = Math::GetClampedToMaxSizePrecise(FBenchVector(Forward.X * State.MoveForward + Right.X * State.MoveRight, Forward.Y * State.MoveForward + Right.Y * State.MoveRight, 0.0f), 1.0f);
+		const auto InputSize = std::sqrt(Math::SizeSquared(Input));
+		const auto WishDirection = Math::GetSafeNormalPrecise(Input);
+		const auto MaxAccel = (bFalling || bWasFalling ? Tuning.MaxAirAcceleration : Tuning.MaxAcceleration);
+		const auto WishSpeed = Tuning.MaxWalkSpeed * (State.bSlowWalk ? 0.3f : 1.0f) * (State.bCrouch ? 0.5f : 1.0f);
+
+		// Autohop: jump whenever the button is held while on the ground, before moving like CheckJumpInput().
+		if (!bFalling && State.bJump)
+		{
+			Velocity.Z = Tuning.Trimping.JumpZVelocity;
+			Math::ApplyTrimpingVelocity(Velocity, FloorNormal, Tuning.Trimping);
+			Velocity.Z *= Math::GetStaminaJumpVelocityMultiplier(Stamina, Tuning.Stamina);
+			Stamina = Math::GetStaminaAfterJump(Tuning.Stamina);
+			bFalling = true;
+		}
+
+		// Velocity phase, with falling latched for one extra tick after landing like CalcVelocity().
+		const auto VerticalVelocity = Velocity.Z;
+		Velocity.Z = 0.0f;
+		if (!bFalling && !bWasFalling)
+		{
+			Math::ApplyFriction(Velocity, DeltaTime, Tuning.GroundFriction, 1.0f, Tuning.StopSpeed);
+			Math::ApplyAcceleration(Velocity, DeltaTime, 1.0f, WishDirection, WishSpeed * InputSize, MaxAccel * InputSize);
+		}
+		else
+		{
+			Math::ApplyAirAcceleration(Velocity, DeltaTime, 1.0f, WishDirection, WishSpeed * InputSize, Tuning.MaxFallAirSpeed, MaxAccel * InputSize);
+		}
+		Velocity = Math::GetClampedToMaxSizePrecise(Velocity, Tuning.EnforcedMaxSpeed);
+		Velocity.Z = VerticalVelocity;
+		bWasFalling = bFalling;
+
+		// Integrate & land on the floor.
+		if (bFalling)
+		{
+			Velocity.Z += BenchGravityZ * DeltaTime;
+		}
+		Location = FBenchVector(Location.X + Velocity.X * DeltaTime, Location.Y + Velocity.Y * DeltaTime, Location.Z + Velocity.Z * DeltaTime);
+		if (bFalling && Location.Z <= 0.0f)
+		{
+			Location.Z = 0.0f;
+			Velocity.Z = 0.0f;
+			bFalling = false;
+		}
+
+		Stamina = Math::DecayStamina(Stamina, DeltaTime);
+
+		const float Values[] = { Location.X, Location.Y, Location.Z, Velocity.X, Velocity.Y, Velocity.Z };
+		Hash = HashTrajectory(Hash, Values, 6);
+	}
+
+	return Hash;
+}
+
+// Replays an input recording (or a synthetic one) through the movement math several times, reporting the cost per tick
+// and checking that every run produced the same trajectory.
+// Usage: SD5BunnyGunReplayBenchmark [RecordingFile]
+int main(int argc, char** argv)
+{
+	std::vector<uint8_t> Data;
+	if (argc > 1)
+	{
+		std::ifstream File(argv[1], std::ios::binary);
+		Data.assign(std::istreambuf_iterator<char>(File), std::istreambuf_iterator<char>());
+	}
+	else
+	{
+		WriteInputRecording(MakeSyntheticRecording(), Data);
+	}
+
+	FInputRecording Recording;
+	if (!ReadInputRecording(Data.data(), Data.size(), Recording))
+	{
+		std::printf("Not a valid input recording!\n");
+		return 1;
+	}
+
+	std::printf("Replaying %zu frames (%zu bytes) at %g s per tick\n", Recording.Frames.size(), Data.size(), Recording.FixedDeltaTime);
+
+	const FBenchTuning Tuning;
+	uint64_t FirstHash = 0;
+	auto bIdentical = true;
+	for (auto Run = 0; Run < BenchReplayRuns; ++Run)
+	{
+		const FBenchTimer Timer;
+		const auto Hash = ReplayBenchRecording(Recording, Tuning);
+		const auto Seconds = Timer.GetElapsedSeconds();
+
+		FirstHash = (Run == 0 ? Hash : FirstHash);
+		bIdentical = bIdentical && Hash == FirstHash;
+		std::printf("Replay %d: %.2f ns/tick, trajectory hash %016" PRIx64 "\n", Run, (Seconds * 1.e9) / std::max<size_t>(1, Recording.Frames.size()), Hash);
+	}
+
+	if (!bIdentical)
+	{
+		std::printf("Replays produced different trajectories!\n");
+		return 1;
+	}
+
+	return 0;
+}
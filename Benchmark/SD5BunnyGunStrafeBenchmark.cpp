@@ -0,0 +1,248 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGunBenchmarkCommon.h"
+
+using namespace SD5BunnyGunBenchmark;
+namespace Math = SD5BunnyGunMovementMath;
+
+// Number of velocities checked against the brute force search, for every tuning.
+static const int StrafeSamples = 5000;
+
+// Number of wish directions tried by the brute force search.
+static const int StrafeSearchAngles = 7200;
+
+// The closed form may gain at most this much less speed (cm/s) in a tick than the brute force search.
+static const float StrafeGainTolerance = 1.e-2f;
+
+// Number of bots timed & the number of ticks simulated for each.
+static const size_t StrafeTimedBots = 100000;
+static const uint32_t StrafeTimedTicks = 40;
+
+// Number of ticks of bunnyhopping simulated to compare the reached speed (20 seconds at 60 Hz).
+static const uint32_t StrafeSimTicks = 60 * 20;
+
+// Bots & ticks simulated following finite path points (a minute at 60 Hz), & the path following settings of
+// ASD5BunnyGunBotController.
+static const uint32_t StrafePathBots = 500;
+static const uint32_t StrafePathTicks = 60 * 60;
+static const float StrafeWanderRadius = 2500.0f;
+static const float StrafeAcceptanceRadius = 200.0f;
+static const float StrafeOvershootTime = 0.5f;
+static const float StrafeStuckTime = 3.0f;
+
+// Strafing bots that move on from passed points may be stuck at most this many times per bot per minute.
+static const double StrafeMaxStuckResets = 1.0;
+
+// Air tunings checked: MaxAirAcceleration & MaxFallAirSpeed. The first is the default (accel over the air wish speed).
+struct FStrafeTuning
+{
+	float MaxAirAcceleration;
+	float MaxFallAirSpeed;
+};
+static const FStrafeTuning StrafeTunings[] = { { 20.0f, 100.0f }, { 10.0f, 100.0f }, { 5.0f, 100.0f }, { 1.0f, 30.0f }, { 100.0f, 30.0f } };
+
+// Returns the horizontal speed after air accelerating with a wish direction for a tick.
+static float GetSpeedAfterAirAcceleration(const FBenchVector& Velocity, const FBenchVector& WishDirection, const FStrafeTuning& Air, const FBenchTuning& Tuning)
+{
+	auto NewVelocity = Velocity;
+	Math::ApplyAirAcceleration(NewVelocity, BenchDeltaTime, 1.0f, WishDirection, Tuning.MaxWalkSpeed, Air.MaxFallAirSpeed, Air.MaxAirAcceleration);
+	return std::sqrt(NewVelocity.X * NewVelocity.X + NewVelocity.Y * NewVelocity.Y);
+}
+
+// Simulates bunnyhopping with autohop towards +X for StrafeSimTicks, returning the speed along +X at the end. Holding
+// forward is what path following does; strafing uses the closed form wish direction.
+static float SimulateStrafeHopping(bool bStrafe, const FStrafeTuning& Air, const FBenchTuning& Tuning)
+{
+	const auto TargetDirection = FBenchVector(1.0f, 0.0f, 0.0f);
+	auto Velocity = FBenchVector();
+	auto Side = 1.0f;
+
+	for (uint32_t Tick = 0; Tick < StrafeSimTicks; ++Tick)
+	{
+		// Landing for a single tick between hops keeps the falling movement mode (see CalcVelocity()), so it is all air movement.
+		const auto WishDirection = (bStrafe ? Math::GetOptimalAirStrafeDirection(Velocity, TargetDirection, BenchDeltaTime, 1.0f, Tuning.MaxWalkSpeed, Air.MaxFallAirSpeed, Air.MaxAirAcceleration, Side) : TargetDirection);
+		Math::ApplyAirAcceleration(Velocity, BenchDeltaTime, 1.0f, WishDirection, Tuning.MaxWalkSpeed, Air.MaxFallAirSpeed, Air.MaxAirAcceleration);
+		Velocity = Math::GetClampedToMaxSizePrecise(Velocity, Tuning.EnforcedMaxSpeed);
+	}
+
+	return Velocity.X;
+}
+
+// Path points moved on from by the simulated bots, per bot per minute.
+struct FStrafePathResult
+{
+	double Reached;
+	double Passed;
+	double StuckResets;
+};
+
+// Simulates bots bunnyhopping to random path points around their home location, like ASD5BunnyGunBotController: a point
+// is reached within the acceptance radius, passed if the bot overshot it (when bAdvancePassed), and given up on (a stuck
+// reset) if the bot hasn't got any closer to it in StrafeStuckTime.
+static FStrafePathResult SimulateStrafePaths(bool bStrafe, bool bAdvancePassed, const FBenchTuning& Tuning)
+{
+	const auto& Air = StrafeTunings[0];
+	auto Reached = 0u, Passed = 0u, StuckResets = 0u;
+
+	for (uint32_t Bot = 0; Bot < StrafePathBots; ++Bot)
+	{
+		auto Seed = 0x5D5u + Bot;
+		auto Location = FBenchVector();
+		auto Velocity = FBenchVector();
+		auto Side = 1.0f;
+
+		FBenchVector PathPoint;
+		auto ClosestDistanceSquared = 0.0f;
+		uint32_t LastProgressTick = 0;
+		const auto PickPathPoint = [&](uint32_t Tick)
+		{
+			const auto Angle = BenchRandom(Seed) * 2.0f * Math::Pi;
+			const auto Distance = (0.25f + 0.75f * BenchRandom(Seed)) * StrafeWanderRadius;
+			PathPoint = FBenchVector(std::cos(Angle) * Distance, std::sin(Angle) * Distance, 0.0f);
+			ClosestDistanceSquared = 1.e30f;
+			LastProgressTick = Tick;
+		};
+		PickPathPoint(0);
+
+		for (uint32_t Tick = 0; Tick < StrafePathTicks; ++Tick)
+		{
+			const auto ToPoint = FBenchVector(PathPoint.X - Location.X, PathPoint.Y - Location.Y, 0.0f);
+			const auto DistanceSquared = Math::SizeSquared(ToPoint);
+			if (DistanceSquared < StrafeAcceptanceRadius * StrafeAcceptanceRadius)
+			{
+				++Reached;
+				PickPathPoint(Tick);
+			}
+			else if (bAdvancePassed && Math::ShouldAdvancePathPoint(Location, Velocity, PathPoint, StrafeAcceptanceRadius, StrafeOvershootTime))
+			{
+				++Passed;
+				PickPathPoint(Tick);
+			}
+			else if (DistanceSquared < ClosestDistanceSquared)
+			{
+				ClosestDistanceSquared = DistanceSquared;
+				LastProgressTick = Tick;
+			}
+			else if ((Tick - LastProgressTick) * BenchDeltaTime > StrafeStuckTime)
+			{
+				++StuckResets;
+				PickPathPoint(Tick);
+			}
+
+			const auto InvDistance = 1.0f / std::sqrt(Math::SizeSquared(FBenchVector(PathPoint.X - Location.X, PathPoint.Y - Location.Y, 0.0f)));
+			const auto TargetDirection = FBenchVector((PathPoint.X - Location.X) * InvDistance, (PathPoint.Y - Location.Y) * InvDistance, 0.0f);
+			const auto WishDirection = (bStrafe ? Math::GetOptimalAirStrafeDirection(Velocity, TargetDirection, BenchDeltaTime, 1.0f, Tuning.MaxWalkSpeed, Air.MaxFallAirSpeed, Air.MaxAirAcceleration, Side) : TargetDirection);
+			Math::ApplyAirAcceleration(Velocity, BenchDeltaTime, 1.0f, WishDirection, Tuning.MaxWalkSpeed, Air.MaxFallAirSpeed, Air.MaxAirAcceleration);
+			Velocity = Math::GetClampedToMaxSizePrecise(Velocity, Tuning.EnforcedMaxSpeed);
+			Location = FBenchVector(Location.X + Velocity.X * BenchDeltaTime, Location.Y + Velocity.Y * BenchDeltaTime, 0.0f);
+		}
+	}
+
+	const auto Minutes = (static_cast<double>(StrafePathBots) * StrafePathTicks * BenchDeltaTime) / 60.0;
+	FStrafePathResult Result;
+	Result.Reached = Reached / Minutes;
+	Result.Passed = Passed / Minutes;
+	Result.StuckResets = StuckResets / Minutes;
+	return Result;
+}
+
+// Checks that the closed form wish direction gains as much speed as a brute force search over every direction, times it
+// for many bots & compares the speed reached by strafing against holding forward, then follows finite path points. Fails
+// if the closed form gains less, or if strafing bots still get stuck circling the path points.
+int main()
+{
+	const FBenchTuning Tuning;
+	auto bPassed = true;
+
+	std::printf("Closed form against a brute force search of %d directions (speed gain per tick, cm/s)\n", StrafeSearchAngles);
+	std::printf("%-24s %16s %16s\n", "MaxAirAccel/AirSpeed", "worst shortfall", "max gain");
+	for (const auto& Air : StrafeTunings)
+	{
+		auto Seed = 0x5D5u;
+		auto WorstShortfall = 0.0f;
+		auto MaxGain = 0.0f;
+		for (auto Sample = 0; Sample < StrafeSamples; ++Sample)
+		{
+			const auto Yaw = BenchRandom(Seed) * 2.0f * Math::Pi;
+			const auto Speed = BenchRandom(Seed) * 3000.0f;
+			const auto Velocity = FBenchVector(std::cos(Yaw) * Speed, std::sin(Yaw) * Speed, 0.0f);
+
+			auto Side = 1.0f;
+			const auto TargetYaw = BenchRandom(Seed) * 2.0f * Math::Pi;
+			const auto TargetDirection = FBenchVector(std::cos(TargetYaw), std::sin(TargetYaw), 0.0f);
+			const auto WishDirection = Math::GetOptimalAirStrafeDirection(Velocity, TargetDirection, BenchDeltaTime, 1.0f, Tuning.MaxWalkSpeed, Air.MaxFallAirSpeed, Air.MaxAirAcceleration, Side);
+			const auto ClosedFormSpeed = GetSpeedAfterAirAcceleration(Velocity, WishDirection, Air, Tuning);
+
+			auto BestSpeed = 0.0f;
+			for (auto Angle = 0; Angle < StrafeSearchAngles; ++Angle)
+			{
+				const auto SearchYaw = (Angle * 2.0f * Math::Pi) / StrafeSearchAngles;
+				BestSpeed = std::max(BestSpeed, GetSpeedAfterAirAcceleration(Velocity, FBenchVector(std::cos(SearchYaw), std::sin(SearchYaw), 0.0f), Air, Tuning));
+			}
+
+			// Heading straight for the target when too slow to strafe is allowed to gain less than the best direction.
+			if (Math::GetOptimalAirStrafeCos(Speed, std::min(Tuning.MaxWalkSpeed, Air.MaxFallAirSpeed), Air.MaxAirAcceleration * Tuning.MaxWalkSpeed * BenchDeltaTime) < 1.0f)
+			{
+				WorstShortfall = std::max(WorstShortfall, BestSpeed - ClosedFormSpeed);
+			}
+			MaxGain = std::max(MaxGain, ClosedFormSpeed - Speed);
+		}
+
+		const auto bTuningPassed = WorstShortfall <= StrafeGainTolerance;
+		bPassed = bPassed && bTuningPassed;
+
+		char Name[32];
+		std::snprintf(Name, sizeof(Name), "%g/%g", Air.MaxAirAcceleration, Air.MaxFallAirSpeed);
+		std::printf("%-24s %16.5f %16.3f %s\n", Name, WorstShortfall, MaxGain, (bTuningPassed ? "ok" : "GAINS LESS"));
+	}
+
+	// Speed reached bunnyhopping towards a target, holding forward (path following) against strafing.
+	std::printf("\nSpeed towards the target after %u ticks of bunnyhopping (cm/s)\n", StrafeSimTicks);
+	std::printf("%-24s %16s %16s\n", "MaxAirAccel/AirSpeed", "hold forward", "strafe");
+	for (const auto& Air : StrafeTunings)
+	{
+		char Name[32];
+		std::snprintf(Name, sizeof(Name), "%g/%g", Air.MaxAirAcceleration, Air.MaxFallAirSpeed);
+		std::printf("%-24s %16.1f %16.1f\n", Name, SimulateStrafeHopping(false, Air, Tuning), SimulateStrafeHopping(true, Air, Tuning));
+	}
+
+	// Path points moved on from when following finite targets.
+	std::printf("\nFollowing random path points (per bot per minute)\n");
+	std::printf("%-24s %16s %16s %16s\n", "Wish direction", "reached", "passed", "stuck resets");
+	const auto PrintPaths = [](const char* Name, const FStrafePathResult& Result)
+	{
+		std::printf("%-24s %16.1f %16.1f %16.1f\n", Name, Result.Reached, Result.Passed, Result.StuckResets);
+	};
+	PrintPaths("hold forward", SimulateStrafePaths(false, false, Tuning));
+	PrintPaths("strafe", SimulateStrafePaths(true, false, Tuning));
+	const auto PathResult = SimulateStrafePaths(true, true, Tuning);
+	PrintPaths("strafe + advance passed", PathResult);
+	if (PathResult.StuckResets > StrafeMaxStuckResets)
+	{
+		std::printf("Strafing bots got stuck circling path points more than %g times per minute\n", StrafeMaxStuckResets);
+		bPassed = false;
+	}
+
+	// Cost per bot per tick.
+	auto Characters = MakeBenchCharacters(StrafeTimedBots);
+	std::vector<float> Sides(StrafeTimedBots, 1.0f);
+	const auto TargetDirection = FBenchVector(1.0f, 0.0f, 0.0f);
+	const auto& Air = StrafeTunings[0];
+
+	const FBenchTimer Timer;
+	for (uint32_t Tick = 0; Tick < StrafeTimedTicks; ++Tick)
+	{
+		for (size_t Index = 0; Index < Characters.size(); ++Index)
+		{
+			auto& Character = Characters[Index];
+			Character.WishDirection = Math::GetOptimalAirStrafeDirection(Character.Velocity, TargetDirection, BenchDeltaTime, 1.0f, Tuning.MaxWalkSpeed, Air.MaxFallAirSpeed, Air.MaxAirAcceleration, Sides[Index]);
+			Math::ApplyAirAcceleration(Character.Velocity, BenchDeltaTime, 1.0f, Character.WishDirection, Tuning.MaxWalkSpeed, Air.MaxFallAirSpeed, Air.MaxAirAcceleration);
+		}
+	}
+	const auto Seconds = Timer.GetElapsedSeconds();
+
+	std::printf("\nClosed form wish direction + air acceleration: %.2f ns per bot per tick (checksum %g)\n",
+		(Seconds * 1.e9) / (static_cast<double>(StrafeTimedBots) * StrafeTimedTicks), GetBenchChecksum(Characters));
+
+	return (bPassed ? 0 : 1);
+}
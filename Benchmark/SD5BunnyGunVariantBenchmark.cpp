@@ -0,0 +1,238 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGunBenchmarkCommon.h"
+
+#include <cstring>
+#include <string>
+
+using namespace SD5BunnyGunBenchmark;
+namespace Math = SD5BunnyGunMovementMath;
+
+// Mirrors ESD5BunnyGunMovementVariant.
+enum EVariantFeature
+{
+	VariantFeature_Stamina = 1 << 0,
+	VariantFeature_Trimping = 1 << 1,
+	VariantFeature_EnforcedMaxSpeed = 1 << 2
+};
+
+// Number of variants (combinations of the features above).
+static const uint32_t NumVariants = 1 << 3;
+
+// Number of characters simulated for every variant.
+static const size_t VariantCharacters = 1000;
+
+// Every update is timed this many times, keeping the fastest run.
+static const int VariantRuns = 5;
+
+// The tuning values the variants precompute once, like USD5BunnyGunCharacterMovement::UpdateMovementVariant().
+struct FVariantTuning
+{
+	FBenchTuning Tuning;
+	float StaminaAfterJump;
+};
+
+// Runtime switches of the branched update, like the bEnableStamina, bEnableTrimping & bUseEnforcedMaxSpeed properties.
+struct FVariantFlags
+{
+	bool bEnableStamina;
+	bool bEnableTrimping;
+	bool bUseEnforcedMaxSpeed;
+};
+
+typedef void (*FBranchedUpdateFunction)(FBenchCharacter& Character, const FBenchTuning& Tuning, const FVariantFlags& Flags);
+typedef void (*FVariantUpdateFunction)(FBenchCharacter& Character, const FVariantTuning& Tuning);
+
+// One tick of the velocity phase & jump as they were before the variants: every feature is checked at runtime, and
+// the stamina left after a jump is worked out by every jump.
+static void UpdateBranched(FBenchCharacter& Character, const FBenchTuning& Tuning, const FVariantFlags& Flags)
+{
+	const auto DeltaTime = BenchDeltaTime;
+	if (Flags.bEnableStamina)
+	{
+		Character.Stamina = Math::DecayStamina(Character.Stamina, DeltaTime);
+	}
+
+	if (IsBenchCharacterOnGround(Character))
+	{
+		if (Flags.bEnableStamina && Character.Stamina > 0.0f)
+		{
+			const auto WalkMultiplier = Math::GetStaminaWalkSpeedMultiplier(Character.Stamina, DeltaTime, Tuning.Stamina);
+			Character.Velocity.X *= WalkMultiplier;
+			Character.Velocity.Y *= WalkMultiplier;
+		}
+
+		Math::ApplyFriction(Character.Velocity, DeltaTime, Tuning.GroundFriction, 1.0f, Tuning.StopSpeed);
+		Math::ApplyAcceleration(Character.Velocity, DeltaTime, 1.0f, Character.WishDirection, Tuning.MaxWalkSpeed, Tuning.MaxAcceleration);
+	}
+	else
+	{
+		Math::ApplyAirAcceleration(Character.Velocity, DeltaTime, 1.0f, Character.WishDirection, Tuning.MaxWalkSpeed, Tuning.MaxFallAirSpeed, Tuning.MaxAirAcceleration);
+	}
+
+	if (Flags.bUseEnforcedMaxSpeed)
+	{
+		Character.Velocity = Math::GetClampedToMaxSizePrecise(Character.Velocity, Tuning.EnforcedMaxSpeed);
+	}
+
+	// Jump straight away again.
+	if (IsBenchCharacterOnGround(Character))
+	{
+		Character.Velocity.Z = Tuning.Trimping.JumpZVelocity;
+		if (Flags.bEnableTrimping)
+		{
+			Math::ApplyTrimpingVelocity(Character.Velocity, Character.FloorNormal, Tuning.Trimping);
+		}
+		if (Flags.bEnableStamina)
+		{
+			Character.Velocity.Z *= Math::GetStaminaJumpVelocityMultiplier(Character.Stamina, Tuning.Stamina);
+			Character.Stamina = Math::GetStaminaAfterJump(Tuning.Stamina);
+		}
+	}
+
+	TurnBenchCharacter(Character);
+	++Character.Tick;
+}
+
+// The same tick specialised for a variant, like SolveVelocityPhaseVariant() & ApplyJumpVariant(). The feature checks are
+// compile time constants.
+template <uint32_t Features>
+static void UpdateVariant(FBenchCharacter& Character, const FVariantTuning& VariantTuning)
+{
+	const auto& Tuning = VariantTuning.Tuning;
+	const auto DeltaTime = BenchDeltaTime;
+	if ((Features & VariantFeature_Stamina) != 0)
+	{
+		Character.Stamina = Math::DecayStamina(Character.Stamina, DeltaTime);
+	}
+
+	if (IsBenchCharacterOnGround(Character))
+	{
+		if ((Features & VariantFeature_Stamina) != 0 && Character.Stamina > 0.0f)
+		{
+			const auto WalkMultiplier = Math::GetStaminaWalkSpeedMultiplier(Character.Stamina, DeltaTime, Tuning.Stamina);
+			Character.Velocity.X *= WalkMultiplier;
+			Character.Velocity.Y *= WalkMultiplier;
+		}
+
+		Math::ApplyFriction(Character.Velocity, DeltaTime, Tuning.GroundFriction, 1.0f, Tuning.StopSpeed);
+		Math::ApplyAcceleration(Character.Velocity, DeltaTime, 1.0f, Character.WishDirection, Tuning.MaxWalkSpeed, Tuning.MaxAcceleration);
+	}
+	else
+	{
+		Math::ApplyAirAcceleration(Character.Velocity, DeltaTime, 1.0f, Character.WishDirection, Tuning.MaxWalkSpeed, Tuning.MaxFallAirSpeed, Tuning.MaxAirAcceleration);
+	}
+
+	if ((Features & VariantFeature_EnforcedMaxSpeed) != 0)
+	{
+		Character.Velocity = Math::GetClampedToMaxSizePrecise(Character.Velocity, Tuning.EnforcedMaxSpeed);
+	}
+
+	// Jump straight away again.
+	if (IsBenchCharacterOnGround(Character))
+	{
+		Character.Velocity.Z = Tuning.Trimping.JumpZVelocity;
+		if ((Features & VariantFeature_Trimping) != 0)
+		{
+			Math::ApplyTrimpingVelocity(Character.Velocity, Character.FloorNormal, Tuning.Trimping);
+		}
+		if ((Features & VariantFeature_Stamina) != 0)
+		{
+			Character.Velocity.Z *= Math::GetStaminaJumpVelocityMultiplier(Character.Stamina, Tuning.Stamina);
+			Character.Stamina = VariantTuning.StaminaAfterJump;
+		}
+	}
+
+	TurnBenchCharacter(Character);
+	++Character.Tick;
+}
+
+// Every variant, indexed by their features (like the tables of USD5BunnyGunCharacterMovement).
+static const FVariantUpdateFunction VariantUpdates[NumVariants] =
+{
+	&UpdateVariant<0>, &UpdateVariant<1>, &UpdateVariant<2>, &UpdateVariant<3>,
+	&UpdateVariant<4>, &UpdateVariant<5>, &UpdateVariant<6>, &UpdateVariant<7>
+};
+
+static std::string GetVariantName(uint32_t Features)
+{
+	std::string Name;
+	Name += ((Features & VariantFeature_Stamina) != 0 ? "stamina " : "");
+	Name += ((Features & VariantFeature_Trimping) != 0 ? "trimp " : "");
+	Name += ((Features & VariantFeature_EnforcedMaxSpeed) != 0 ? "maxspeed" : "");
+	return (Name.empty() ? std::string("none") : Name);
+}
+
+// Runs Update on every character for Ticks ticks, VariantRuns times from the same start, returning the fastest ns per update.
+template <typename UpdateType>
+static double TimeVariantUpdates(uint32_t Ticks, std::vector<FBenchCharacter>& OutCharacters, UpdateType Update)
+{
+	auto BestNs = 0.0;
+	for (auto Run = 0; Run < VariantRuns; ++Run)
+	{
+		OutCharacters = MakeBenchCharacters(VariantCharacters);
+		const FBenchTimer Timer;
+		for (uint32_t Tick = 0; Tick < Ticks; ++Tick)
+		{
+			for (auto& Character : OutCharacters)
+			{
+				Update(Character);
+			}
+		}
+
+		const auto Ns = (Timer.GetElapsedSeconds() * 1.e9) / (static_cast<double>(VariantCharacters) * Ticks);
+		BestNs = (Run == 0 || Ns < BestNs ? Ns : BestNs);
+	}
+
+	return BestNs;
+}
+
+// Returns whether or not both runs left every character in the exact same state.
+static bool AreVariantCharactersIdentical(const std::vector<FBenchCharacter>& A, const std::vector<FBenchCharacter>& B)
+{
+	for (size_t Index = 0; Index < A.size(); ++Index)
+	{
+		if (std::memcmp(&A[Index].Velocity, &B[Index].Velocity, sizeof(FBenchVector)) != 0 || std::memcmp(&A[Index].Stamina, &B[Index].Stamina, sizeof(float)) != 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Times the runtime-branched update against the specialised variant for every combination of features. Both are called
+// through a function pointer per character, like the movement component. Fails if a variant doesn't give the exact same
+// velocities & stamina as the branched update.
+int main()
+{
+	FVariantTuning VariantTuning;
+	VariantTuning.StaminaAfterJump = Math::GetStaminaAfterJump(VariantTuning.Tuning.Stamina);
+
+	const auto Ticks = GetBenchTicks(VariantCharacters);
+	volatile FBranchedUpdateFunction BranchedUpdate = &UpdateBranched;
+	auto bPassed = true;
+
+	std::printf("Movement variants, %zu characters x %u ticks (ns/update)\n", VariantCharacters, Ticks);
+	std::printf("%-28s %16s %16s %16s\n", "Features", "branched", "variant", "speedup");
+	for (uint32_t Features = 0; Features < NumVariants; ++Features)
+	{
+		FVariantFlags Flags;
+		Flags.bEnableStamina = (Features & VariantFeature_Stamina) != 0;
+		Flags.bEnableTrimping = (Features & VariantFeature_Trimping) != 0;
+		Flags.bUseEnforcedMaxSpeed = (Features & VariantFeature_EnforcedMaxSpeed) != 0;
+
+		std::vector<FBenchCharacter> BranchedCharacters, SpecialisedCharacters;
+		const FBranchedUpdateFunction Branched = BranchedUpdate;
+		const auto BranchedNs = TimeVariantUpdates(Ticks, BranchedCharacters, [&](FBenchCharacter& Character) { Branched(Character, VariantTuning.Tuning, Flags); });
+
+		const auto Variant = VariantUpdates[Features];
+		const auto VariantNs = TimeVariantUpdates(Ticks, SpecialisedCharacters, [&](FBenchCharacter& Character) { Variant(Character, VariantTuning); });
+
+		const auto bIdentical = AreVariantCharactersIdentical(BranchedCharacters, SpecialisedCharacters);
+		bPassed = bPassed && bIdentical;
+		std::printf("%-28s %16.2f %16.2f %15.2fx %s\n", GetVariantName(Features).c_str(), BranchedNs, VariantNs, BranchedNs / VariantNs, (bIdentical ? "ok" : "DIFFERENT RESULT"));
+	}
+
+	return (bPassed ? 0 : 1);
+}
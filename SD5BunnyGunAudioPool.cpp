@@ -0,0 +1,220 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGun.h"
+#include "SD5BunnyGunAudioPool.h"
+#include "SD5BunnyGunStats.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sounds Requested"), STAT_BunnyGunSoundsRequested, STATGROUP_BunnyGun);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sounds Culled (Distance)"), STAT_BunnyGunSoundsCulledDistance, STATGROUP_BunnyGun);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sounds Culled (Concurrency)"), STAT_BunnyGunSoundsCulledConcurrency, STATGROUP_BunnyGun);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sounds Replaced"), STAT_BunnyGunSoundsReplaced, STATGROUP_BunnyGun);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Audio Components Created"), STAT_BunnyGunAudioComponentsCreated, STATGROUP_BunnyGun);
+
+static TAutoConsoleVariable<int32> CVarAudioPool(
+	TEXT("BunnyGun.AudioPool"),
+	1,
+	TEXT("Whether or not Bunny Gun character sounds are culled & played from a pool of audio components.\n")
+	TEXT("0: a new audio component is created for every sound, 1: enabled"));
+
+static TAutoConsoleVariable<int32> CVarAudioPoolSize(
+	TEXT("BunnyGun.AudioPoolSize"),
+	32,
+	TEXT("Maximum number of pooled audio components per world. When they are all playing, the farthest sound is replaced by a nearer one."));
+
+static TAutoConsoleVariable<int32> CVarAudioMaxConcurrency(
+	TEXT("BunnyGun.AudioMaxConcurrency"),
+	4,
+	TEXT("Maximum number of instances of the same sound playing at once from the audio pool (the nearest ones are kept).\n")
+	TEXT("0: no limit"));
+
+TSD5BunnyGunWorldRegistry<FSD5BunnyGunWorldAudioPool> FSD5BunnyGunAudioPool::WorldPools(&FSD5BunnyGunAudioPool::OnWorldCleanup);
+
+FSD5BunnyGunPooledSound::FSD5BunnyGunPooledSound() :
+Component(nullptr),
+ListenerDistanceSquared(0.0f)
+{ }
+
+FSD5BunnyGunWorldAudioPool::FSD5BunnyGunWorldAudioPool(UWorld* InWorld) :
+World(InWorld)
+{ }
+
+void FSD5BunnyGunWorldAudioPool::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (auto& Sound : Sounds)
+	{
+		Collector.AddReferencedObject(Sound.Component);
+	}
+}
+
+UAudioComponent* FSD5BunnyGunAudioPool::PlaySoundAtLocation(UWorld* World, USoundBase* Sound, const FVector& Location)
+{
+	return PlaySound(World, Sound, Location, nullptr);
+}
+
+UAudioComponent* FSD5BunnyGunAudioPool::PlaySoundAttached(USoundBase* Sound, USceneComponent* AttachToComponent)
+{
+	if (AttachToComponent == nullptr)
+	{
+		return nullptr;
+	}
+
+	return PlaySound(AttachToComponent->GetWorld(), Sound, AttachToComponent->GetComponentLocation(), AttachToComponent);
+}
+
+UAudioComponent* FSD5BunnyGunAudioPool::PlaySound(UWorld* World, USoundBase* Sound, const FVector& Location, USceneComponent* AttachToComponent)
+{
+	if (World == nullptr || Sound == nullptr || World->GetNetMode() == NM_DedicatedServer || World->GetAudioDevice() == nullptr)
+	{
+		return nullptr;
+	}
+
+	INC_DWORD_STAT(STAT_BunnyGunSoundsRequested);
+
+	// Old behaviour, for comparing against.
+	if (CVarAudioPool.GetValueOnGameThread() == 0)
+	{
+		INC_DWORD_STAT(STAT_BunnyGunAudioComponentsCreated);
+		if (AttachToComponent != nullptr)
+		{
+			return UGameplayStatics::PlaySoundAttached(Sound, AttachToComponent);
+		}
+
+		UGameplayStatics::PlaySoundAtLocation(World, Sound, Location);
+		return nullptr;
+	}
+
+	// Don't bother if no listener can hear it.
+	const auto ListenerDistanceSquared = GetListenerDistanceSquared(World, Location);
+	const auto MaxAudibleDistance = Sound->GetMaxAudibleDistance();
+	if (MaxAudibleDistance < WORLD_MAX && ListenerDistanceSquared > FMath::Square(MaxAudibleDistance))
+	{
+		INC_DWORD_STAT(STAT_BunnyGunSoundsCulledDistance);
+		return nullptr;
+	}
+
+	auto& Sounds = WorldPools.FindOrAdd(World, World).Sounds;
+	Sounds.RemoveAllSwap([](const FSD5BunnyGunPooledSound& PooledSound) { return PooledSound.Component == nullptr || PooledSound.Component->IsPendingKill(); });
+
+	// Find a free component, and the farthest playing sounds in case we need to replace one.
+	auto FreeIndex = INDEX_NONE;
+	auto FarthestIndex = INDEX_NONE;
+	auto FarthestSameSoundIndex = INDEX_NONE;
+	auto NumSameSound = 0;
+	for (auto Index = 0; Index < Sounds.Num(); ++Index)
+	{
+		const auto& PooledSound = Sounds[Index];
+		if (!PooledSound.Component->IsPlaying())
+		{
+			FreeIndex = (FreeIndex == INDEX_NONE ? Index : FreeIndex);
+			continue;
+		}
+
+		if (PooledSound.Component->Sound == Sound)
+		{
+			++NumSameSound;
+			if (FarthestSameSoundIndex == INDEX_NONE || PooledSound.ListenerDistanceSquared > Sounds[FarthestSameSoundIndex].ListenerDistanceSquared)
+			{
+				FarthestSameSoundIndex = Index;
+			}
+		}
+
+		if (FarthestIndex == INDEX_NONE || PooledSound.ListenerDistanceSquared > Sounds[FarthestIndex].ListenerDistanceSquared)
+		{
+			FarthestIndex = Index;
+		}
+	}
+
+	auto SoundIndex = FreeIndex;
+	const auto MaxConcurrency = CVarAudioMaxConcurrency.GetValueOnGameThread();
+	if (MaxConcurrency > 0 && NumSameSound >= MaxConcurrency)
+	{
+		// Too many of this sound are playing already - only play it if it is nearer than one of them.
+		if (ListenerDistanceSquared >= Sounds[FarthestSameSoundIndex].ListenerDistanceSquared)
+		{
+			INC_DWORD_STAT(STAT_BunnyGunSoundsCulledConcurrency);
+			return nullptr;
+		}
+
+		INC_DWORD_STAT(STAT_BunnyGunSoundsReplaced);
+		SoundIndex = FarthestSameSoundIndex;
+	}
+	else if (SoundIndex == INDEX_NONE && Sounds.Num() < CVarAudioPoolSize.GetValueOnGameThread())
+	{
+		const auto AudioComponent = NewObject<UAudioComponent>(World->GetWorldSettings());
+		AudioComponent->bAutoActivate = false;
+		AudioComponent->bAutoDestroy = false;
+		AudioComponent->bStopWhenOwnerDestroyed = false;
+		AudioComponent->RegisterComponentWithWorld(World);
+		INC_DWORD_STAT(STAT_BunnyGunAudioComponentsCreated);
+
+		SoundIndex = Sounds.AddDefaulted();
+		Sounds[SoundIndex].Component = AudioComponent;
+	}
+	else if (SoundIndex == INDEX_NONE)
+	{
+		// The pool is full - only play it if it is nearer than one of the playing sounds.
+		if (FarthestIndex == INDEX_NONE || ListenerDistanceSquared >= Sounds[FarthestIndex].ListenerDistanceSquared)
+		{
+			INC_DWORD_STAT(STAT_BunnyGunSoundsCulledConcurrency);
+			return nullptr;
+		}
+
+		INC_DWORD_STAT(STAT_BunnyGunSoundsReplaced);
+		SoundIndex = FarthestIndex;
+	}
+
+	auto& PooledSound = Sounds[SoundIndex];
+	const auto AudioComponent = PooledSound.Component;
+	AudioComponent->Stop();
+	if (AudioComponent->AttachParent != nullptr)
+	{
+		AudioComponent->DetachFromParent();
+	}
+
+	AudioComponent->SetSound(Sound);
+	if (AttachToComponent != nullptr)
+	{
+		AudioComponent->AttachTo(AttachToComponent, NAME_None, EAttachLocation::SnapToTarget);
+	}
+	else
+	{
+		AudioComponent->SetWorldLocation(Location);
+	}
+
+	AudioComponent->Play();
+	PooledSound.ListenerDistanceSquared = ListenerDistanceSquared;
+
+	return AudioComponent;
+}
+
+float FSD5BunnyGunAudioPool::GetListenerDistanceSquared(UWorld* World, const FVector& Location)
+{
+	auto MinDistanceSquared = -1.0f;
+	for (auto It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		const auto PlayerController = *It;
+		if (PlayerController == nullptr || !PlayerController->IsLocalController())
+		{
+			continue;
+		}
+
+		FVector ListenerLocation, ListenerFrontDir, ListenerRightDir;
+		PlayerController->GetAudioListenerPosition(ListenerLocation, ListenerFrontDir, ListenerRightDir);
+
+		const auto DistanceSquared = FVector::DistSquared(ListenerLocation, Location);
+		MinDistanceSquared = (MinDistanceSquared < 0.0f ? DistanceSquared : FMath::Min(MinDistanceSquared, DistanceSquared));
+	}
+
+	return FMath::Max(MinDistanceSquared, 0.0f);
+}
+
+void FSD5BunnyGunAudioPool::OnWorldCleanup(FSD5BunnyGunWorldAudioPool& Pool)
+{
+	for (auto& PooledSound : Pool.Sounds)
+	{
+		if (PooledSound.Component != nullptr && !PooledSound.Component->IsPendingKill())
+		{
+			PooledSound.Component->DestroyComponent();
+		}
+	}
+}
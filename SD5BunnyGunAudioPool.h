@@ -0,0 +1,74 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+#include "SD5BunnyGunWorldRegistry.h"
+
+/**
+ * A pooled audio component & what it was last started for.
+ */
+struct FSD5BunnyGunPooledSound
+{
+	// The component (owned by the pool).
+	UAudioComponent* Component;
+
+	// Squared distance from the nearest listener when the sound was started, used to pick which sound to replace.
+	float ListenerDistanceSquared;
+
+	FSD5BunnyGunPooledSound();
+};
+
+/**
+ * The audio components of a world that are shared by every Bunny Gun character.
+ */
+struct FSD5BunnyGunWorldAudioPool : public FGCObject
+{
+	// The world the sounds play in.
+	UWorld* World;
+
+	// Every component created for this world so far (at most BunnyGun.AudioPoolSize).
+	TArray<FSD5BunnyGunPooledSound> Sounds;
+
+	explicit FSD5BunnyGunWorldAudioPool(UWorld* InWorld);
+
+	// Keeps the pooled components from being garbage collected.
+	void AddReferencedObjects(FReferenceCollector& Collector) override;
+};
+
+/**
+ * Plays the one-shot sounds of the Bunny Gun characters (jumping, hits, fall damage & death) from a per-world pool of
+ * audio components, instead of creating a new component for every sound. Sounds are culled before a component is
+ * picked: when the nearest local listener is out of their attenuation range, or when too many instances of the same
+ * sound are already playing nearer to the listener. When the pool is full, the farthest playing sound is replaced by
+ * a nearer one. Nothing is played on dedicated servers.
+ *
+ * "stat BunnyGun" shows the sounds requested, culled & the audio components created per frame.
+ *
+ * Console variables:
+ *   BunnyGun.AudioPool 0/1              Disables/enables the pool (0 creates a component per sound, to compare against).
+ *   BunnyGun.AudioPoolSize <Num>        Maximum number of audio components per world.
+ *   BunnyGun.AudioMaxConcurrency <Num>  Maximum number of instances of the same sound playing at once (0 for no limit).
+ */
+class SD5BUNNYGUN_API FSD5BunnyGunAudioPool
+{
+public:
+	// Plays a sound at a location. Returns nullptr if the sound was culled (or not played by a pooled component).
+	static UAudioComponent* PlaySoundAtLocation(UWorld* World, USoundBase* Sound, const FVector& Location);
+
+	// Plays a sound that follows a component. Returns nullptr if the sound was culled (or not played by a pooled component).
+	// NOTE: The pool may give the returned component to another sound once this one has finished.
+	static UAudioComponent* PlaySoundAttached(USoundBase* Sound, USceneComponent* AttachToComponent);
+
+private:
+	// Culls the sound, or starts it on a free (or replaced) pooled component.
+	static UAudioComponent* PlaySound(UWorld* World, USoundBase* Sound, const FVector& Location, USceneComponent* AttachToComponent);
+
+	// Returns the squared distance from Location to the nearest local listener (0 if there are none).
+	static float GetListenerDistanceSquared(UWorld* World, const FVector& Location);
+
+	// Destroys the components of the pool of a world that is being cleaned up.
+	static void OnWorldCleanup(FSD5BunnyGunWorldAudioPool& Pool);
+
+	// The audio pool of each world that has played a sound.
+	static TSD5BunnyGunWorldRegistry<FSD5BunnyGunWorldAudioPool> WorldPools;
+};
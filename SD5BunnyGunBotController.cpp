@@ -0,0 +1,226 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGun.h"
+#include "SD5BunnyGunBotController.h"
+#include "SD5BunnyGunCharacter.h"
+#include "SD5BunnyGunCharacterMovement.h"
+#include "EngineUtils.h"
+#include "AI/Navigation/NavigationPath.h"
+#include "AI/Navigation/NavigationSystem.h"
+
+ASD5BunnyGunBotController::ASD5BunnyGunBotController(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer),
+	WanderRadius(2500.0f),
+	PathPointAcceptanceRadius(200.0f),
+	PathPointOvershootTime(0.5f),
+	StuckTime(3.0f),
+	ShootInterval(1.0f),
+	ShotDamage(20.0f),
+	ShotRange(3000.0f),
+	LaunchInterval(20.0f),
+	LaunchZVelocity(1500.0f),
+	Kills(0),
+	HomeLocation(FVector::ZeroVector),
+	BotTime(0.0f),
+	StrafeSide(1.0f),
+	PathPointIndex(0),
+	ClosestPathPointDistanceSquared(BIG_NUMBER),
+	LastPathProgressTime(0.0f),
+	NextShootTime(0.0f),
+	NextLaunchTime(0.0f),
+	NextCrouchToggleTime(0.0f),
+	NextSlowWalkToggleTime(0.0f)
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// Bots have player states like real players, so that they cost the same to replicate.
+	bWantsPlayerState = true;
+}
+
+void ASD5BunnyGunBotController::InitBot(int32 BotIndex, const FVector& InHomeLocation)
+{
+	RandomStream.Initialize(0x5D5 + BotIndex);
+	HomeLocation = InHomeLocation;
+	PathPoints.Reset();
+	SetPathPointIndex(0);
+
+	NextShootTime = GetRandomInterval(ShootInterval);
+	NextLaunchTime = GetRandomInterval(LaunchInterval);
+	NextCrouchToggleTime = GetRandomInterval(5.0f);
+	NextSlowWalkToggleTime = GetRandomInterval(7.0f);
+}
+
+float ASD5BunnyGunBotController::GetRandomInterval(float AverageInterval)
+{
+	return BotTime + AverageInterval * RandomStream.FRandRange(0.5f, 1.5f);
+}
+
+void ASD5BunnyGunBotController::Possess(APawn* InPawn)
+{
+	Super::Possess(InPawn);
+
+	const auto Character = Cast<ASD5BunnyGunCharacter>(InPawn);
+	if (Character != nullptr)
+	{
+		// Hold jump for the whole life of the bot & let autohop do the rest.
+		Character->bUseAutoHop = true;
+		Character->StartJumping();
+	}
+}
+
+void ASD5BunnyGunBotController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	const auto Character = Cast<ASD5BunnyGunCharacter>(GetPawn());
+	if (Character == nullptr || !Character->IsAlive())
+	{
+		return;
+	}
+
+	BotTime += DeltaSeconds;
+
+	// Move on to the next path point once we are close enough to this one, or have gone past it.
+	const auto Location = Character->GetActorLocation();
+	const auto Velocity = Character->GetVelocity();
+	auto NewPathPointIndex = PathPointIndex;
+	while (NewPathPointIndex < PathPoints.Num() && SD5BunnyGunMovementMath::ShouldAdvancePathPoint(Location, Velocity, PathPoints[NewPathPointIndex], PathPointAcceptanceRadius, PathPointOvershootTime))
+	{
+		++NewPathPointIndex;
+	}
+	if (NewPathPointIndex != PathPointIndex)
+	{
+		SetPathPointIndex(NewPathPointIndex);
+	}
+
+	// Give up on the goal if we haven't got any closer to the path point for a while (e.g. stuck against a wall).
+	if (PathPointIndex < PathPoints.Num())
+	{
+		const auto DistanceSquared = FVector::DistSquared2D(Location, PathPoints[PathPointIndex]);
+		if (DistanceSquared < ClosestPathPointDistanceSquared)
+		{
+			ClosestPathPointDistanceSquared = DistanceSquared;
+			LastPathProgressTime = BotTime;
+		}
+		else if (BotTime - LastPathProgressTime > StuckTime)
+		{
+			PathPoints.Reset();
+		}
+	}
+
+	if (PathPointIndex >= PathPoints.Num())
+	{
+		PickNewGoal(Character);
+	}
+
+	// Air-strafe towards the path point, or just head straight for it on the ground.
+	const auto TargetDirection = (PathPointIndex < PathPoints.Num() ? (PathPoints[PathPointIndex] - Location).GetSafeNormal2D() : Character->GetActorForwardVector());
+	const auto MoveComponent = static_cast<USD5BunnyGunCharacterMovement*>(Character->GetCharacterMovement());
+	const auto WishDirection = MoveComponent->GetOptimalAirStrafeDirection(TargetDirection, DeltaSeconds, StrafeSide);
+
+	// Look where we are strafing, like a player turning with the mouse.
+	SetControlRotation(FRotator(0.0f, WishDirection.Rotation().Yaw, 0.0f));
+	Character->AddMovementInput(WishDirection, 1.0f);
+
+	if (BotTime >= NextCrouchToggleTime)
+	{
+		NextCrouchToggleTime = GetRandomInterval(Character->CurrentInputState.bCrouch ? 5.0f : 0.5f);
+		if (Character->CurrentInputState.bCrouch)
+		{
+			Character->StopCrouching();
+		}
+		else
+		{
+			Character->StartCrouching();
+		}
+	}
+
+	if (BotTime >= NextSlowWalkToggleTime)
+	{
+		NextSlowWalkToggleTime = GetRandomInterval(Character->CurrentInputState.bSlowWalk ? 7.0f : 1.0f);
+		if (Character->CurrentInputState.bSlowWalk)
+		{
+			Character->StopSlowWalking();
+		}
+		else
+		{
+			Character->StartSlowWalking();
+		}
+	}
+
+	if (BotTime >= NextLaunchTime)
+	{
+		NextLaunchTime = GetRandomInterval(LaunchInterval);
+		Character->LaunchCharacter(FVector(0.0f, 0.0f, LaunchZVelocity), false, true);
+	}
+
+	if (BotTime >= NextShootTime)
+	{
+		NextShootTime = GetRandomInterval(ShootInterval);
+		ShootNearestCharacter(Character);
+	}
+}
+
+void ASD5BunnyGunBotController::PickNewGoal(ASD5BunnyGunCharacter* Character)
+{
+	const auto Angle = RandomStream.FRandRange(0.0f, 2.0f * PI);
+	const auto Goal = HomeLocation + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * RandomStream.FRandRange(0.25f, 1.0f) * WanderRadius;
+
+	PathPoints.Reset();
+	SetPathPointIndex(0);
+
+	const auto Path = UNavigationSystem::FindPathToLocationSynchronously(this, Character->GetActorLocation(), Goal, Character);
+	if (Path != nullptr && Path->IsValid())
+	{
+		PathPoints = Path->PathPoints;
+	}
+	else
+	{
+		PathPoints.Add(Goal);
+	}
+}
+
+void ASD5BunnyGunBotController::SetPathPointIndex(int32 Index)
+{
+	PathPointIndex = Index;
+	ClosestPathPointDistanceSquared = BIG_NUMBER;
+	LastPathProgressTime = BotTime;
+}
+
+void ASD5BunnyGunBotController::ShootNearestCharacter(ASD5BunnyGunCharacter* Character)
+{
+	ASD5BunnyGunCharacter* Target = nullptr;
+	auto TargetDistanceSquared = FMath::Square(ShotRange);
+
+	for (TActorIterator<ASD5BunnyGunCharacter> It(GetWorld()); It; ++It)
+	{
+		if (*It == Character || !It->IsAlive())
+		{
+			continue;
+		}
+
+		const auto DistanceSquared = FVector::DistSquared(It->GetActorLocation(), Character->GetActorLocation());
+		if (DistanceSquared < TargetDistanceSquared)
+		{
+			Target = *It;
+			TargetDistanceSquared = DistanceSquared;
+		}
+	}
+
+	if (Target == nullptr)
+	{
+		return;
+	}
+
+	const auto ShotDirection = (Target->GetActorLocation() - Character->GetActorLocation()).GetSafeNormal();
+
+	FHitResult Hit;
+	Hit.Actor = Target;
+	Hit.ImpactPoint = Target->GetActorLocation();
+
+	Target->TakeDamage(ShotDamage, FPointDamageEvent(ShotDamage, Hit, ShotDirection, USD5BunnyGunDamageType::StaticClass()), this, Character);
+	if (!Target->IsAlive())
+	{
+		++Kills;
+	}
+}
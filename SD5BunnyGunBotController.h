@@ -0,0 +1,100 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+#include "AIController.h"
+#include "SD5BunnyGunBotController.generated.h"
+
+class ASD5BunnyGunCharacter;
+
+/**
+* Headless bot used by the load test (see FSD5BunnyGunLoadTest). Bunnyhops with autohop along navigation paths to random
+* goals around its home location, air-strafing with the wish direction that gains the most speed (a closed form, see
+* SD5BunnyGunMovementMath::GetOptimalAirStrafeDirection(), so it costs next to nothing per bot). It crouches & slow walks
+* now and then, gets launched into the air to take fall damage and shoots the nearest other character through
+* TakeDamage(). Everything random comes from a stream seeded by the bot index, so runs are repeatable.
+*/
+UCLASS()
+class SD5BUNNYGUN_API ASD5BunnyGunBotController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this controller's properties
+	ASD5BunnyGunBotController(const FObjectInitializer& ObjectInitializer);
+
+	// Called every frame
+	void Tick(float DeltaSeconds) override;
+
+	// Called when possessing a pawn
+	void Possess(APawn* InPawn) override;
+
+	// Seeds the random stream of the bot & sets the location it strafes around.
+	void InitBot(int32 BotIndex, const FVector& InHomeLocation);
+
+	// Shoots the nearest other living Bunny Gun character in range, if any.
+	void ShootNearestCharacter(ASD5BunnyGunCharacter* Character);
+
+	// Picks a random goal around the home location & finds a path to it (a straight line if there is no navigation).
+	void PickNewGoal(ASD5BunnyGunCharacter* Character);
+
+	// The distance from the home location that the bot turns back at.
+	UPROPERTY(Category = "Bot", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float WanderRadius;
+
+	// The 2D distance from a path point at which the bot moves on to the next one.
+	UPROPERTY(Category = "Bot", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float PathPointAcceptanceRadius;
+
+	// The bot also moves on from a path point that it is moving away from within this many seconds of its velocity, as it
+	// is too fast to turn back into the acceptance radius (see SD5BunnyGunMovementMath::ShouldAdvancePathPoint()).
+	UPROPERTY(Category = "Bot", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float PathPointOvershootTime;
+
+	// The time (in seconds) without getting any closer to its path point after which the bot picks a new goal.
+	UPROPERTY(Category = "Bot", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float StuckTime;
+
+	// The average time between shots, in seconds.
+	UPROPERTY(Category = "Bot", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float ShootInterval;
+
+	// The damage of each shot.
+	UPROPERTY(Category = "Bot", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float ShotDamage;
+
+	// The range of each shot.
+	UPROPERTY(Category = "Bot", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float ShotRange;
+
+	// The average time between being launched into the air (to take fall damage), in seconds.
+	UPROPERTY(Category = "Bot", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float LaunchInterval;
+
+	// The upwards velocity that the bot is launched with.
+	UPROPERTY(Category = "Bot", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float LaunchZVelocity;
+
+	// The number of characters this bot has killed.
+	int32 Kills;
+
+private:
+	// Returns a random time around an average interval.
+	float GetRandomInterval(float AverageInterval);
+
+	// Moves on to the path point at Index, resetting the progress towards it.
+	void SetPathPointIndex(int32 Index);
+
+	FRandomStream RandomStream;
+	FVector HomeLocation;
+	float BotTime;
+	float StrafeSide;
+	TArray<FVector> PathPoints;
+	int32 PathPointIndex;
+	float ClosestPathPointDistanceSquared;
+	float LastPathProgressTime;
+	float NextShootTime;
+	float NextLaunchTime;
+	float NextCrouchToggleTime;
+	float NextSlowWalkToggleTime;
+};
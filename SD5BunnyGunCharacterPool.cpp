@@ -0,0 +1,123 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGun.h"
+#include "SD5BunnyGunCharacterPool.h"
+#include "SD5BunnyGunCharacter.h"
+#include "SD5BunnyGunStats.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters Spawned"), STAT_BunnyGunCharactersSpawned, STATGROUP_BunnyGun);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters Respawned From Pool"), STAT_BunnyGunCharactersRespawnedFromPool, STATGROUP_BunnyGun);
+
+static TAutoConsoleVariable<int32> CVarCharacterPool(
+	TEXT("BunnyGun.CharacterPool"),
+	0,
+	TEXT("Whether or not dead Bunny Gun characters are pooled & reused for respawning.\n")
+	TEXT("0: dead characters are torn off & destroyed, 1: enabled"));
+
+static TAutoConsoleVariable<int32> CVarCharacterPoolSize(
+	TEXT("BunnyGun.CharacterPoolSize"),
+	32,
+	TEXT("Maximum number of dead characters pooled per world. Characters that die while the pool is full are torn off & destroyed."));
+
+static TAutoConsoleVariable<float> CVarCharacterPoolMinDeadTime(
+	TEXT("BunnyGun.CharacterPoolMinDeadTime"),
+	5.0f,
+	TEXT("How long (in seconds) a pooled character stays dead, with its body visible on the clients, before it can be respawned."));
+
+TSD5BunnyGunWorldRegistry<TArray<FSD5BunnyGunPooledCharacter>> FSD5BunnyGunCharacterPool::WorldPools;
+
+FSD5BunnyGunPooledCharacter::FSD5BunnyGunPooledCharacter() :
+Character(nullptr),
+ReleaseTime(0.0f)
+{ }
+
+ASD5BunnyGunCharacter* FSD5BunnyGunCharacterPool::SpawnCharacter(UWorld* World, TSubclassOf<ASD5BunnyGunCharacter> CharacterClass, const FVector& Location, const FRotator& Rotation,
+	const FActorSpawnParameters& SpawnParameters, bool& bOutWasReused)
+{
+	bOutWasReused = false;
+	if (World == nullptr || CharacterClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	const auto Pool = WorldPools.Find(World);
+	if (Pool != nullptr && CVarCharacterPool.GetValueOnGameThread() != 0)
+	{
+		Pool->RemoveAll([](const FSD5BunnyGunPooledCharacter& PooledCharacter) { return !PooledCharacter.Character.IsValid() || PooledCharacter.Character->IsPendingKill(); });
+
+		// The oldest bodies go first, so that the bodies stay around on the clients for as long as possible.
+		const auto RespawnTime = World->GetTimeSeconds() - CVarCharacterPoolMinDeadTime.GetValueOnGameThread();
+		for (auto Index = 0; Index < Pool->Num() && (*Pool)[Index].ReleaseTime <= RespawnTime; ++Index)
+		{
+			const auto Character = (*Pool)[Index].Character.Get();
+			if (Character->GetClass() != CharacterClass)
+			{
+				continue;
+			}
+
+			Pool->RemoveAt(Index);
+			Character->SetNetDormancy(DORM_Awake);
+			Character->RespawnFromPool(Location, Rotation);
+			INC_DWORD_STAT(STAT_BunnyGunCharactersRespawnedFromPool);
+
+			bOutWasReused = true;
+			return Character;
+		}
+	}
+
+	const auto Character = World->SpawnActor<ASD5BunnyGunCharacter>(CharacterClass, Location, Rotation, SpawnParameters);
+	if (Character != nullptr)
+	{
+		INC_DWORD_STAT(STAT_BunnyGunCharactersSpawned);
+	}
+
+	return Character;
+}
+
+bool FSD5BunnyGunCharacterPool::ReleaseCharacter(ASD5BunnyGunCharacter* Character)
+{
+	if (Character == nullptr || Character->Role != ROLE_Authority || Character->IsPendingKill() || CVarCharacterPool.GetValueOnGameThread() == 0)
+	{
+		return false;
+	}
+
+	const auto World = Character->GetWorld();
+	if (World == nullptr)
+	{
+		return false;
+	}
+
+	auto& Pool = WorldPools.FindOrAdd(World);
+	Pool.RemoveAll([](const FSD5BunnyGunPooledCharacter& PooledCharacter) { return !PooledCharacter.Character.IsValid() || PooledCharacter.Character->IsPendingKill(); });
+	if (Pool.Num() >= CVarCharacterPoolSize.GetValueOnGameThread())
+	{
+		return false;
+	}
+
+	FSD5BunnyGunPooledCharacter PooledCharacter;
+	PooledCharacter.Character = Character;
+	PooledCharacter.ReleaseTime = World->GetTimeSeconds();
+	Pool.Add(PooledCharacter);
+
+	// Nothing about a dead character changes until it is respawned, so stop considering it for replication once the
+	// clients have its death.
+	Character->SetNetDormancy(DORM_DormantAll);
+	return true;
+}
+
+void FSD5BunnyGunCharacterPool::DestroyPooledCharacters(UWorld* World)
+{
+	const auto Pool = WorldPools.Remove(World);
+	if (!Pool.IsValid())
+	{
+		return;
+	}
+
+	for (const auto& PooledCharacter : *Pool)
+	{
+		if (PooledCharacter.Character.IsValid())
+		{
+			PooledCharacter.Character->Destroy();
+		}
+	}
+}
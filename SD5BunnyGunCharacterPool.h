@@ -0,0 +1,58 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+#include "SD5BunnyGunWorldRegistry.h"
+
+class ASD5BunnyGunCharacter;
+
+/**
+ * A dead character waiting in the pool to be respawned.
+ */
+struct FSD5BunnyGunPooledCharacter
+{
+	TWeakObjectPtr<ASD5BunnyGunCharacter> Character;
+
+	// The time the character died & was put in the pool.
+	float ReleaseTime;
+
+	FSD5BunnyGunPooledCharacter();
+};
+
+/**
+ * Respawns Bunny Gun characters by reusing the actors of dead characters, instead of tearing the dead ones off, destroying
+ * them & spawning new ones (along with all of their components) for every respawn. A character that dies on the authority
+ * is put in the pool of its world instead of being torn off (see ASD5BunnyGunCharacter::OnDeath()), and stays dormant with
+ * its body on the clients until BunnyGun.CharacterPoolMinDeadTime has passed. Respawning then takes the character that has
+ * been dead for the longest, resets it (see ASD5BunnyGunCharacter::RespawnFromPool()) & moves it to the spawn location.
+ *
+ * NOTE: Only respawns through SpawnCharacter() (i.e. the load test) take characters from the pool. A game mode that spawns
+ * its characters itself would never reuse them, so dead bodies would stay until the pool is full. It is off by default.
+ *
+ * "stat BunnyGun" shows the characters spawned & respawned from the pool per frame.
+ *
+ * Console variables:
+ *   BunnyGun.CharacterPool 0/1                      Disables/enables the pool (0 tears off & destroys dead characters, the default).
+ *   BunnyGun.CharacterPoolSize <Num>                Maximum number of dead characters pooled per world (the rest are destroyed).
+ *   BunnyGun.CharacterPoolMinDeadTime <Seconds>     How long a character stays dead (with its body visible) before it can be respawned.
+ */
+class SD5BUNNYGUN_API FSD5BunnyGunCharacterPool
+{
+public:
+	// Respawns a pooled character of CharacterClass at a location, or spawns a new one if none can be respawned yet.
+	// bOutWasReused is set to whether or not a pooled character was respawned.
+	// NOTE: The caller has to possess the character, like with a spawned one.
+	static ASD5BunnyGunCharacter* SpawnCharacter(UWorld* World, TSubclassOf<ASD5BunnyGunCharacter> CharacterClass, const FVector& Location, const FRotator& Rotation,
+		const FActorSpawnParameters& SpawnParameters, bool& bOutWasReused);
+
+	// Puts a character that has just died on the authority in the pool of its world.
+	// Returns false if it wasn't pooled (pool disabled or full), in which case it should be torn off & destroyed as usual.
+	static bool ReleaseCharacter(ASD5BunnyGunCharacter* Character);
+
+	// Destroys the pooled characters of a world.
+	static void DestroyPooledCharacters(UWorld* World);
+
+private:
+	// The dead characters of each world, oldest first.
+	static TSD5BunnyGunWorldRegistry<TArray<FSD5BunnyGunPooledCharacter>> WorldPools;
+};
@@ -0,0 +1,98 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGun.h"
+#include "SD5BunnyGunCharacterSignificance.h"
+#include "SD5BunnyGunCharacter.h"
+#include "SD5BunnyGunStats.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters (Full Tick)"), STAT_BunnyGunCharactersFull, STATGROUP_BunnyGun);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters (Reduced Tick)"), STAT_BunnyGunCharactersReduced, STATGROUP_BunnyGun);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters (Hidden Tick)"), STAT_BunnyGunCharactersHidden, STATGROUP_BunnyGun);
+
+static TAutoConsoleVariable<int32> CVarTickSignificance(
+	TEXT("BunnyGun.TickSignificance"),
+	1,
+	TEXT("Whether or not far, off-screen & occluded Bunny Gun characters tick at a lower rate.\n")
+	TEXT("0: every character ticks every frame, 1: enabled"));
+
+TSD5BunnyGunWorldRegistry<FSD5BunnyGunCharacterSignificanceTickFunction> FSD5BunnyGunCharacterSignificance::WorldTickFunctions;
+
+FSD5BunnyGunCharacterSignificanceTickFunction::FSD5BunnyGunCharacterSignificanceTickFunction(UWorld* InWorld) :
+FSD5BunnyGunWorldTickFunction(InWorld, TG_PrePhysics)
+{ }
+
+void FSD5BunnyGunCharacterSignificanceTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (TickType == LEVELTICK_ViewportsOnly || TickType == LEVELTICK_PauseTick)
+	{
+		return;
+	}
+
+	// Without a local player there is nothing to be significant to, so keep everyone at full rate.
+	const auto PlayerController = GEngine->GetFirstLocalPlayerController(World);
+	const auto bEnabled = (CVarTickSignificance.GetValueOnGameThread() != 0 && PlayerController != nullptr);
+
+	FVector ViewLocation(ForceInitToZero);
+	FRotator ViewRotation(ForceInitToZero);
+	if (bEnabled)
+	{
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	}
+
+	for (const auto Character : Characters)
+	{
+		const auto Significance = (bEnabled ? Character->CalcTickSignificance(ViewLocation) : ESD5BunnyGunTickSignificance::Full);
+		Character->SetTickSignificance(Significance);
+
+		switch (Significance)
+		{
+		case ESD5BunnyGunTickSignificance::Full:
+			INC_DWORD_STAT(STAT_BunnyGunCharactersFull);
+			break;
+
+		case ESD5BunnyGunTickSignificance::Reduced:
+			INC_DWORD_STAT(STAT_BunnyGunCharactersReduced);
+			break;
+
+		case ESD5BunnyGunTickSignificance::Hidden:
+			INC_DWORD_STAT(STAT_BunnyGunCharactersHidden);
+			break;
+		}
+	}
+}
+
+FString FSD5BunnyGunCharacterSignificanceTickFunction::DiagnosticMessage()
+{
+	return FString::Printf(TEXT("FSD5BunnyGunCharacterSignificanceTickFunction (%d characters)"), Characters.Num());
+}
+
+void FSD5BunnyGunCharacterSignificance::RegisterCharacter(ASD5BunnyGunCharacter* Character)
+{
+	const auto World = Character->GetWorld();
+	if (World == nullptr || World->PersistentLevel == nullptr)
+	{
+		return;
+	}
+
+	auto& TickFunction = WorldTickFunctions.FindOrAdd(World, World);
+	TickFunction.Characters.AddUnique(Character);
+	Character->PrimaryActorTick.AddPrerequisite(World, TickFunction);
+}
+
+void FSD5BunnyGunCharacterSignificance::UnregisterCharacter(ASD5BunnyGunCharacter* Character)
+{
+	const auto World = Character->GetWorld();
+	const auto TickFunction = WorldTickFunctions.Find(World);
+	if (TickFunction == nullptr || TickFunction->Characters.Remove(Character) <= 0)
+	{
+		return;
+	}
+
+	Character->PrimaryActorTick.RemovePrerequisite(World, *TickFunction);
+
+	// Last character of this world - get rid of the tick function.
+	if (TickFunction->Characters.Num() == 0)
+	{
+		WorldTickFunctions.Remove(World);
+	}
+}
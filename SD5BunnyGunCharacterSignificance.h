@@ -0,0 +1,64 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+#include "SD5BunnyGunWorldRegistry.h"
+
+class ASD5BunnyGunCharacter;
+
+/**
+ * How much of its per-frame work a Bunny Gun character needs to do on this machine.
+ */
+namespace ESD5BunnyGunTickSignificance
+{
+	enum Type
+	{
+		// Ticks every frame (controlled on this machine, or near & visible).
+		Full,
+
+		// Far away from the local player - ticks at ReducedTickInterval.
+		Reduced,
+
+		// Not rendered recently (off-screen or occluded) - ticks at HiddenTickInterval and skips all cosmetic work.
+		Hidden
+	};
+}
+
+/**
+ * Tick function that re-evaluates the tick significance of every registered character in a world each frame.
+ * Runs in TG_PrePhysics before the characters tick (they take it as a prerequisite), so a character that becomes
+ * relevant again ticks at full rate straight away instead of waiting out its old tick interval.
+ */
+struct FSD5BunnyGunCharacterSignificanceTickFunction : public FSD5BunnyGunWorldTickFunction
+{
+	// The characters whose tick rate is managed.
+	TArray<ASD5BunnyGunCharacter*> Characters;
+
+	explicit FSD5BunnyGunCharacterSignificanceTickFunction(UWorld* InWorld);
+
+	// Works out the significance of every character from the view of the first local player.
+	void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	// Describes this tick function for debugging.
+	FString DiagnosticMessage() override;
+};
+
+/**
+ * Keeps track of the character significance tick function of each world.
+ *
+ * Console variables:
+ *   BunnyGun.TickSignificance 0/1   Disables/enables tick significance (to compare "stat BunnyGun" before & after).
+ */
+class SD5BUNNYGUN_API FSD5BunnyGunCharacterSignificance
+{
+public:
+	// Registers a character with the significance tick function of its world (creating it if needed).
+	static void RegisterCharacter(ASD5BunnyGunCharacter* Character);
+
+	// Unregisters a character (destroying the tick function of its world when it was the last one).
+	static void UnregisterCharacter(ASD5BunnyGunCharacter* Character);
+
+private:
+	// The significance tick function of each world with at least one registered character.
+	static TSD5BunnyGunWorldRegistry<FSD5BunnyGunCharacterSignificanceTickFunction> WorldTickFunctions;
+};
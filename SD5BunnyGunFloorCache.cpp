@@ -0,0 +1,238 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGun.h"
+#include "SD5BunnyGunFloorCache.h"
+#include "SD5BunnyGunStats.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Floor Cache Hits"), STAT_BunnyGunFloorCacheHits, STATGROUP_BunnyGun);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Floor Cache Misses"), STAT_BunnyGunFloorCacheMisses, STATGROUP_BunnyGun);
+
+static TAutoConsoleVariable<int32> CVarFloorCache(
+	TEXT("BunnyGun.FloorCache"),
+	1,
+	TEXT("Whether or not floor queries of Bunny Gun characters are cached for flat, static floors.\n")
+	TEXT("0: disabled, 1: characters with bUseFloorCache, 2: every character"));
+
+static TAutoConsoleVariable<float> CVarFloorCacheCellSize(
+	TEXT("BunnyGun.FloorCacheCellSize"),
+	32.0f,
+	TEXT("Size (cm) of the 2D cells that the locations of floor queries are quantized to. Larger cells are found in the cache more often,\n")
+	TEXT("but the edges of floors may be seen up to a cell late."));
+
+static TAutoConsoleVariable<int32> CVarFloorCacheMaxFloors(
+	TEXT("BunnyGun.FloorCacheMaxFloors"),
+	16384,
+	TEXT("Maximum number of floors cached per world. The cache is emptied when it is full."));
+
+// Floors with a normal less vertical than this aren't cached, as their distance changes with the horizontal location.
+static const float FloorCacheMinNormalZ = 0.999f;
+
+// Cached floors are only used within this height of where they were cached from (MAX_FLOOR_DIST), so that steps up &
+// other floors of the same primitive above or below aren't given the cached floor.
+static const float FloorCacheMaxHeightOffset = MAX_FLOOR_DIST;
+
+TSD5BunnyGunWorldRegistry<FSD5BunnyGunWorldFloorCache> FSD5BunnyGunFloorCache::WorldCaches;
+
+FSD5BunnyGunFloorCacheKey::FSD5BunnyGunFloorCacheKey() :
+Floor(nullptr),
+CellX(0),
+CellY(0),
+Radius(0),
+HalfHeight(0),
+LineDistance(0),
+SweepDistance(0),
+SweepRadius(0),
+bUseFlatBase(false)
+{ }
+
+bool FSD5BunnyGunFloorCacheKey::operator==(const FSD5BunnyGunFloorCacheKey& Other) const
+{
+	return Floor == Other.Floor && CellX == Other.CellX && CellY == Other.CellY && Radius == Other.Radius && HalfHeight == Other.HalfHeight &&
+		LineDistance == Other.LineDistance && SweepDistance == Other.SweepDistance && SweepRadius == Other.SweepRadius && bUseFlatBase == Other.bUseFlatBase;
+}
+
+uint32 GetTypeHash(const FSD5BunnyGunFloorCacheKey& Key)
+{
+	auto Hash = HashCombine(PointerHash(Key.Floor), GetTypeHash(Key.CellX));
+	Hash = HashCombine(Hash, GetTypeHash(Key.CellY));
+	Hash = HashCombine(Hash, GetTypeHash(Key.Radius));
+	Hash = HashCombine(Hash, GetTypeHash(Key.HalfHeight));
+	Hash = HashCombine(Hash, GetTypeHash(Key.LineDistance));
+	Hash = HashCombine(Hash, GetTypeHash(Key.SweepDistance));
+	Hash = HashCombine(Hash, GetTypeHash(Key.SweepRadius));
+	return HashCombine(Hash, GetTypeHash(Key.bUseFlatBase ? 1 : 0));
+}
+
+FSD5BunnyGunWorldFloorCache::FSD5BunnyGunWorldFloorCache() :
+NumLookups(0),
+NumHits(0),
+NumQueries(0),
+QueryMs(0.0)
+{ }
+
+FSD5BunnyGunFloorCacheStats::FSD5BunnyGunFloorCacheStats() :
+NumLookups(0),
+NumHits(0),
+QueryMs(0.0f),
+SavedMs(0.0f)
+{ }
+
+float FSD5BunnyGunFloorCacheStats::GetHitRate() const
+{
+	return (NumLookups > 0 ? static_cast<float>(NumHits) / NumLookups : 0.0f);
+}
+
+bool FSD5BunnyGunFloorCache::IsEnabled(bool bComponentUsesCache)
+{
+	const auto FloorCache = CVarFloorCache.GetValueOnGameThread();
+	return (FloorCache >= 2 || (FloorCache == 1 && bComponentUsesCache));
+}
+
+FSD5BunnyGunFloorCacheKey FSD5BunnyGunFloorCache::MakeKey(const UPrimitiveComponent* LastFloor, const FVector& CapsuleLocation, float Radius, float HalfHeight, float LineDistance, float SweepDistance, float SweepRadius, bool bUseFlatBase)
+{
+	const auto CellSize = FMath::Max(CVarFloorCacheCellSize.GetValueOnGameThread(), 0.1f);
+
+	FSD5BunnyGunFloorCacheKey Key;
+	Key.Floor = LastFloor;
+	Key.CellX = FMath::FloorToInt(CapsuleLocation.X / CellSize);
+	Key.CellY = FMath::FloorToInt(CapsuleLocation.Y / CellSize);
+	Key.Radius = FMath::RoundToInt(Radius * 10.0f);
+	Key.HalfHeight = FMath::RoundToInt(HalfHeight * 10.0f);
+	Key.LineDistance = FMath::RoundToInt(LineDistance * 10.0f);
+	Key.SweepDistance = FMath::RoundToInt(SweepDistance * 10.0f);
+	Key.SweepRadius = FMath::RoundToInt(SweepRadius * 10.0f);
+	Key.bUseFlatBase = bUseFlatBase;
+
+	return Key;
+}
+
+bool FSD5BunnyGunFloorCache::FindFloor(UWorld* World, const FSD5BunnyGunFloorCacheKey& Key, const FVector& CapsuleLocation, float LineDistance, float SweepDistance, FFindFloorResult& OutFloorResult)
+{
+	if (World == nullptr)
+	{
+		return false;
+	}
+
+	auto& Cache = GetWorldCache(World);
+	++Cache.NumLookups;
+
+	const auto CachedFloor = Cache.Floors.Find(Key);
+	if (CachedFloor == nullptr)
+	{
+		INC_DWORD_STAT(STAT_BunnyGunFloorCacheMisses);
+		return false;
+	}
+
+	// The sweep goes straight down, so starting higher only makes the floor farther away. The floor is flat, so the
+	// horizontal offset doesn't change the distance.
+	const auto Offset = CapsuleLocation - CachedFloor->CapsuleLocation;
+	const auto FloorDist = CachedFloor->Floor.FloorDist + Offset.Z;
+	const auto LineDist = CachedFloor->Floor.LineDist + Offset.Z;
+	if (FMath::Abs(Offset.Z) > FloorCacheMaxHeightOffset || FloorDist < 0.0f || FloorDist > SweepDistance || (CachedFloor->Floor.bLineTrace && (LineDist < 0.0f || LineDist > LineDistance)))
+	{
+		INC_DWORD_STAT(STAT_BunnyGunFloorCacheMisses);
+		return false;
+	}
+
+	OutFloorResult = CachedFloor->Floor;
+	OutFloorResult.FloorDist = FloorDist;
+	OutFloorResult.LineDist = (OutFloorResult.bLineTrace ? LineDist : OutFloorResult.LineDist);
+
+	const auto HorizontalOffset = FVector(Offset.X, Offset.Y, 0.0f);
+	auto& Hit = OutFloorResult.HitResult;
+	Hit.TraceStart += Offset;
+	Hit.TraceEnd += Offset;
+	Hit.Location += HorizontalOffset;
+	Hit.ImpactPoint += HorizontalOffset;
+
+	++Cache.NumHits;
+	INC_DWORD_STAT(STAT_BunnyGunFloorCacheHits);
+	return true;
+}
+
+void FSD5BunnyGunFloorCache::AddFloor(UWorld* World, const FSD5BunnyGunFloorCacheKey& Key, const FVector& CapsuleLocation, const FFindFloorResult& FloorResult, uint32 QueryCycles)
+{
+	if (World == nullptr)
+	{
+		return;
+	}
+
+	auto& Cache = GetWorldCache(World);
+	++Cache.NumQueries;
+	Cache.QueryMs += FPlatformTime::ToMilliseconds(QueryCycles);
+
+	// Only flat floors that can never move, on the floor of the key (a query that found another floor is at its edge).
+	// No floor at all isn't cached either, as something may move in the way.
+	const auto& Hit = FloorResult.HitResult;
+	const auto Component = Hit.Component.Get();
+	if (!FloorResult.bBlockingHit || Hit.bStartPenetrating || Hit.ImpactNormal.Z < FloorCacheMinNormalZ || Hit.Normal.Z < FloorCacheMinNormalZ ||
+		Component == nullptr || Component != Key.Floor || Component->Mobility != EComponentMobility::Static)
+	{
+		return;
+	}
+
+	if (Cache.Floors.Num() >= CVarFloorCacheMaxFloors.GetValueOnGameThread())
+	{
+		Cache.Floors.Empty();
+	}
+
+	auto& CachedFloor = Cache.Floors.Add(Key);
+	CachedFloor.CapsuleLocation = CapsuleLocation;
+	CachedFloor.Floor = FloorResult;
+}
+
+FSD5BunnyGunFloorCacheStats FSD5BunnyGunFloorCache::GetStats(UWorld* World)
+{
+	FSD5BunnyGunFloorCacheStats Stats;
+
+	const auto Cache = WorldCaches.Find(World);
+	if (Cache == nullptr)
+	{
+		return Stats;
+	}
+
+	Stats.NumLookups = Cache->NumLookups;
+	Stats.NumHits = Cache->NumHits;
+	Stats.QueryMs = static_cast<float>(Cache->QueryMs);
+	Stats.SavedMs = (Cache->NumQueries > 0 ? (Stats.QueryMs / Cache->NumQueries) * Cache->NumHits : 0.0f);
+
+	return Stats;
+}
+
+void FSD5BunnyGunFloorCache::ResetStats(UWorld* World)
+{
+	const auto Cache = WorldCaches.Find(World);
+	if (Cache == nullptr)
+	{
+		return;
+	}
+
+	Cache->NumLookups = 0;
+	Cache->NumHits = 0;
+	Cache->NumQueries = 0;
+	Cache->QueryMs = 0.0;
+}
+
+FSD5BunnyGunWorldFloorCache& FSD5BunnyGunFloorCache::GetWorldCache(UWorld* World)
+{
+	// NOTE: Bound once, for every world (WorldCaches removes the caches of worlds that are cleaned up).
+	static auto bBoundLevelDelegates = false;
+	if (!bBoundLevelDelegates)
+	{
+		FWorldDelegates::LevelAddedToWorld.AddStatic(&FSD5BunnyGunFloorCache::OnLevelChanged);
+		FWorldDelegates::LevelRemovedFromWorld.AddStatic(&FSD5BunnyGunFloorCache::OnLevelChanged);
+		bBoundLevelDelegates = true;
+	}
+
+	return WorldCaches.FindOrAdd(World);
+}
+
+void FSD5BunnyGunFloorCache::OnLevelChanged(ULevel* Level, UWorld* World)
+{
+	// The floors of the level came in or went away - nothing cached can be trusted anymore.
+	const auto Cache = WorldCaches.Find(World);
+	if (Cache != nullptr)
+	{
+		Cache->Floors.Empty();
+	}
+}
@@ -0,0 +1,135 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+#include "SD5BunnyGunWorldRegistry.h"
+
+/**
+ * What a floor query is cached by: the floor the character was last on, the 2D cell of the capsule location, the capsule
+ * size & the query distances.
+ */
+struct FSD5BunnyGunFloorCacheKey
+{
+	// NOTE: Only compared, never dereferenced.
+	const UPrimitiveComponent* Floor;
+
+	int32 CellX;
+	int32 CellY;
+
+	// The capsule size & distances of the query, in 0.1 cm steps.
+	int32 Radius;
+	int32 HalfHeight;
+	int32 LineDistance;
+	int32 SweepDistance;
+	int32 SweepRadius;
+
+	bool bUseFlatBase;
+
+	FSD5BunnyGunFloorCacheKey();
+
+	bool operator==(const FSD5BunnyGunFloorCacheKey& Other) const;
+
+	friend uint32 GetTypeHash(const FSD5BunnyGunFloorCacheKey& Key);
+};
+
+/**
+ * A cached floor & the capsule location it was found from.
+ */
+struct FSD5BunnyGunCachedFloor
+{
+	FVector CapsuleLocation;
+	FFindFloorResult Floor;
+};
+
+/**
+ * The cached floors of a world & how well the cache is doing.
+ */
+struct FSD5BunnyGunWorldFloorCache
+{
+	TMap<FSD5BunnyGunFloorCacheKey, FSD5BunnyGunCachedFloor> Floors;
+
+	// Floor queries looked up in the cache, and how many of them were found.
+	int32 NumLookups;
+	int32 NumHits;
+
+	// Floor queries that were computed after missing the cache, and the time spent on them.
+	int32 NumQueries;
+	double QueryMs;
+
+	FSD5BunnyGunWorldFloorCache();
+};
+
+/**
+ * How well the floor cache of a world is doing (see FSD5BunnyGunFloorCache::GetStats()).
+ */
+struct FSD5BunnyGunFloorCacheStats
+{
+	int32 NumLookups;
+	int32 NumHits;
+
+	// Time spent on the floor queries that missed the cache, and the estimated time saved by the hits (at the average time of a query).
+	float QueryMs;
+	float SavedMs;
+
+	FSD5BunnyGunFloorCacheStats();
+
+	// Returns the fraction of lookups that were found in the cache.
+	float GetHitRate() const;
+};
+
+/**
+ * Caches the floor queries of the characters that use it (see USD5BunnyGunCharacterMovement::bUseFloorCache) per world,
+ * so that characters moving over the same floors don't sweep for them again. Only floors that are static geometry &
+ * flat are cached, which is where the flat base floor sweeps of fast characters are repeated the most.
+ *
+ * A query is found in the cache when the character was last on the same floor primitive, is in the same 2D cell
+ * (BunnyGun.FloorCacheCellSize) & is within MAX_FLOOR_DIST of the height the floor was cached from, with the same capsule
+ * size & distances. Only floors found on the primitive of the key are cached. As the floor sweep goes straight down, the
+ * cached floor distance is corrected by the height difference between the two locations.
+ * NOTE: A cell that crosses the edge of a floor gives its cached floor for the whole cell, so walking off a ledge or onto
+ * another floor may be seen up to a cell late. Movable objects on top of a cached floor (e.g. other characters) are not
+ * seen by queries found in the cache either.
+ *
+ * Most hits are walking characters querying from the same cell over several ticks; bunnyhoppers only query when they land.
+ * Benchmark/SD5BunnyGunFloorCacheBenchmark.cpp simulates the hit rate & the wrong floors for a few cell sizes.
+ *
+ * The cache of a world is emptied when a level is added to or removed from it, and when it holds BunnyGun.FloorCacheMaxFloors.
+ * "stat BunnyGun" shows the hits & misses per frame.
+ *
+ * Console variables:
+ *   BunnyGun.FloorCache 0/1/2                   Disables the cache, enables it for the characters with bUseFloorCache, or for every character.
+ *   BunnyGun.FloorCacheCellSize <cm>            Size of the 2D cells that query locations are quantized to.
+ *   BunnyGun.FloorCacheMaxFloors <Num>          Maximum number of floors cached per world.
+ */
+class SD5BUNNYGUN_API FSD5BunnyGunFloorCache
+{
+public:
+	// Returns whether or not a movement component with bUseFloorCache set to bComponentUsesCache should use the cache.
+	static bool IsEnabled(bool bComponentUsesCache);
+
+	// Makes the key of a floor query.
+	static FSD5BunnyGunFloorCacheKey MakeKey(const UPrimitiveComponent* LastFloor, const FVector& CapsuleLocation, float Radius, float HalfHeight, float LineDistance, float SweepDistance, float SweepRadius, bool bUseFlatBase);
+
+	// Looks for the floor of a query in the cache. Returns false if it isn't cached (or the cached floor is out of the query's range).
+	static bool FindFloor(UWorld* World, const FSD5BunnyGunFloorCacheKey& Key, const FVector& CapsuleLocation, float LineDistance, float SweepDistance, FFindFloorResult& OutFloorResult);
+
+	// Caches the floor of a query that missed the cache, if it is a flat floor of static geometry on the floor primitive of
+	// the key. QueryCycles is the time the query took.
+	static void AddFloor(UWorld* World, const FSD5BunnyGunFloorCacheKey& Key, const FVector& CapsuleLocation, const FFindFloorResult& FloorResult, uint32 QueryCycles);
+
+	// Gets how well the cache of a world has done since the stats were last reset.
+	static FSD5BunnyGunFloorCacheStats GetStats(UWorld* World);
+
+	// Resets the stats of the cache of a world.
+	static void ResetStats(UWorld* World);
+
+private:
+	// Returns the cache of a world, creating it if needed.
+	static FSD5BunnyGunWorldFloorCache& GetWorldCache(UWorld* World);
+
+	// Empties the cache of the world the level is streamed into or out of.
+	static void OnLevelChanged(ULevel* Level, UWorld* World);
+
+	// The floor cache of each world that has used it.
+	static TSD5BunnyGunWorldRegistry<FSD5BunnyGunWorldFloorCache> WorldCaches;
+};
@@ -0,0 +1,258 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * Compact binary format for the per-tick input of a Bunny Gun character, used to record a real match and replay it
+ * headlessly at a fixed timestep (see SD5BunnyGunInputReplay.h).
+ *
+ * Engine-free so that recordings can also be read by the standalone benchmarks. All values are little-endian:
+ *
+ *   Header (32 bytes): "BGIR", uint16 version, uint16 reserved, float fixed delta time,
+ *                      float start location X/Y/Z, float start yaw, uint32 number of frames
+ *   Frame (8 bytes):   int8 MoveForward, int8 MoveRight, uint8 buttons, uint8 reserved, uint16 pitch, uint16 yaw
+ */
+namespace SD5BunnyGunInputRecording
+{
+	const uint16_t InputRecordingVersion = 1;
+	const size_t InputRecordingHeaderSize = 32;
+	const size_t InputRecordingFrameSize = 8;
+
+	// Buttons held down during a frame.
+	enum EInputButtons : uint8_t
+	{
+		InputButton_Jump = 1 << 0,
+		InputButton_Crouch = 1 << 1,
+		InputButton_SlowWalk = 1 << 2
+	};
+
+	// Unquantized input of a character for a single tick.
+	struct FInputState
+	{
+		float MoveForward;
+		float MoveRight;
+		bool bJump;
+		bool bCrouch;
+		bool bSlowWalk;
+		float Pitch;
+		float Yaw;
+
+		FInputState() : MoveForward(0.0f), MoveRight(0.0f), bJump(false), bCrouch(false), bSlowWalk(false), Pitch(0.0f), Yaw(0.0f) { }
+	};
+
+	// Quantized input of a character for a single tick.
+	struct FInputFrame
+	{
+		int8_t MoveForward;
+		int8_t MoveRight;
+		uint8_t Buttons;
+		uint16_t Pitch;
+		uint16_t Yaw;
+	};
+
+	// A whole recording.
+	struct FInputRecording
+	{
+		// The timestep the recording is replayed at.
+		float FixedDeltaTime;
+
+		// Where the recorded character was when the recording started.
+		float StartLocation[3];
+		float StartYaw;
+
+		std::vector<FInputFrame> Frames;
+
+		FInputRecording() : FixedDeltaTime(1.0f / 60.0f), StartYaw(0.0f)
+		{
+			StartLocation[0] = StartLocation[1] = StartLocation[2] = 0.0f;
+		}
+	};
+
+	// Maps an axis value in [-1, 1] to [-127, 127].
+	inline int8_t QuantizeAxis(float Value)
+	{
+		const auto Clamped = (Value < -1.0f ? -1.0f : (Value > 1.0f ? 1.0f : Value));
+		return static_cast<int8_t>(std::lround(Clamped * 127.0f));
+	}
+
+	inline float DequantizeAxis(int8_t Value)
+	{
+		return static_cast<float>(Value) / 127.0f;
+	}
+
+	// Same mapping as FRotator::CompressAxisToShort().
+	inline uint16_t QuantizeAngle(float Degrees)
+	{
+		return static_cast<uint16_t>(static_cast<int32_t>(std::lround(Degrees * 65536.0f / 360.0f)) & 0xFFFF);
+	}
+
+	// Same mapping as FRotator::DecompressAxisFromShort().
+	inline float DequantizeAngle(uint16_t Value)
+	{
+		return (Value * 360.0f) / 65536.0f;
+	}
+
+	inline FInputFrame QuantizeInputState(const FInputState& State)
+	{
+		FInputFrame Frame;
+		Frame.MoveForward = QuantizeAxis(State.MoveForward);
+		Frame.MoveRight = QuantizeAxis(State.MoveRight);
+		Frame.Buttons = static_cast<uint8_t>((State.bJump ? InputButton_Jump : 0) | (State.bCrouch ? InputButton_Crouch : 0) | (State.bSlowWalk ? InputButton_SlowWalk : 0));
+		Frame.Pitch = QuantizeAngle(State.Pitch);
+		Frame.Yaw = QuantizeAngle(State.Yaw);
+
+		return Frame;
+	}
+
+	inline FInputState DequantizeInputFrame(const FInputFrame& Frame)
+	{
+		FInputState State;
+		State.MoveForward = DequantizeAxis(Frame.MoveForward);
+		State.MoveRight = DequantizeAxis(Frame.MoveRight);
+		State.bJump = (Frame.Buttons & InputButton_Jump) != 0;
+		State.bCrouch = (Frame.Buttons & InputButton_Crouch) != 0;
+		State.bSlowWalk = (Frame.Buttons & InputButton_SlowWalk) != 0;
+		State.Pitch = DequantizeAngle(Frame.Pitch);
+		State.Yaw = DequantizeAngle(Frame.Yaw);
+
+		return State;
+	}
+
+	namespace InputRecordingDetail
+	{
+		inline void WriteU16(std::vector<uint8_t>& Out, uint16_t Value)
+		{
+			Out.push_back(static_cast<uint8_t>(Value & 0xFF));
+			Out.push_back(static_cast<uint8_t>(Value >> 8));
+		}
+
+		inline void WriteU32(std::vector<uint8_t>& Out, uint32_t Value)
+		{
+			WriteU16(Out, static_cast<uint16_t>(Value & 0xFFFF));
+			WriteU16(Out, static_cast<uint16_t>(Value >> 16));
+		}
+
+		inline void WriteFloat(std::vector<uint8_t>& Out, float Value)
+		{
+			uint32_t Bits;
+			std::memcpy(&Bits, &Value, sizeof(Bits));
+			WriteU32(Out, Bits);
+		}
+
+		inline uint16_t ReadU16(const uint8_t* Data)
+		{
+			return static_cast<uint16_t>(Data[0] | (Data[1] << 8));
+		}
+
+		inline uint32_t ReadU32(const uint8_t* Data)
+		{
+			return static_cast<uint32_t>(ReadU16(Data)) | (static_cast<uint32_t>(ReadU16(Data + 2)) << 16);
+		}
+
+		inline float ReadFloat(const uint8_t* Data)
+		{
+			const auto Bits = ReadU32(Data);
+			float Value;
+			std::memcpy(&Value, &Bits, sizeof(Value));
+			return Value;
+		}
+	}
+
+	// Serializes the recording into Out (replacing its contents).
+	inline void WriteInputRecording(const FInputRecording& Recording, std::vector<uint8_t>& Out)
+	{
+		using namespace InputRecordingDetail;
+
+		Out.clear();
+		Out.reserve(InputRecordingHeaderSize + Recording.Frames.size() * InputRecordingFrameSize);
+
+		Out.push_back('B');
+		Out.push_back('G');
+		Out.push_back('I');
+		Out.push_back('R');
+		WriteU16(Out, InputRecordingVersion);
+		WriteU16(Out, 0);
+		WriteFloat(Out, Recording.FixedDeltaTime);
+		WriteFloat(Out, Recording.StartLocation[0]);
+		WriteFloat(Out, Recording.StartLocation[1]);
+		WriteFloat(Out, Recording.StartLocation[2]);
+		WriteFloat(Out, Recording.StartYaw);
+		WriteU32(Out, static_cast<uint32_t>(Recording.Frames.size()));
+
+		for (const auto& Frame : Recording.Frames)
+		{
+			Out.push_back(static_cast<uint8_t>(Frame.MoveForward));
+			Out.push_back(static_cast<uint8_t>(Frame.MoveRight));
+			Out.push_back(Frame.Buttons);
+			Out.push_back(0);
+			WriteU16(Out, Frame.Pitch);
+			WriteU16(Out, Frame.Yaw);
+		}
+	}
+
+	// Parses a recording. Returns false if the data is not a valid recording of a supported version.
+	inline bool ReadInputRecording(const uint8_t* Data, size_t Size, FInputRecording& OutRecording)
+	{
+		using namespace InputRecordingDetail;
+
+		if (Data == nullptr || Size < InputRecordingHeaderSize || std::memcmp(Data, "BGIR", 4) != 0 || ReadU16(Data + 4) != InputRecordingVersion)
+		{
+			return false;
+		}
+
+		const auto NumFrames = static_cast<size_t>(ReadU32(Data + 28));
+		if ((Size - InputRecordingHeaderSize) / InputRecordingFrameSize < NumFrames)
+		{
+			return false;
+		}
+
+		OutRecording.FixedDeltaTime = ReadFloat(Data + 8);
+		OutRecording.StartLocation[0] = ReadFloat(Data + 12);
+		OutRecording.StartLocation[1] = ReadFloat(Data + 16);
+		OutRecording.StartLocation[2] = ReadFloat(Data + 20);
+		OutRecording.StartYaw = ReadFloat(Data + 24);
+		if (!(OutRecording.FixedDeltaTime > 0.0f))
+		{
+			return false;
+		}
+
+		OutRecording.Frames.resize(NumFrames);
+		for (size_t Index = 0; Index < NumFrames; ++Index)
+		{
+			const auto FrameData = Data + InputRecordingHeaderSize + Index * InputRecordingFrameSize;
+			auto& Frame = OutRecording.Frames[Index];
+			Frame.MoveForward = static_cast<int8_t>(FrameData[0]);
+			Frame.MoveRight = static_cast<int8_t>(FrameData[1]);
+			Frame.Buttons = FrameData[2];
+			Frame.Pitch = ReadU16(FrameData + 4);
+			Frame.Yaw = ReadU16(FrameData + 6);
+		}
+
+		return true;
+	}
+
+	// FNV-1a hash of a sequence of floats (by their bits), for checking that two replays produced identical trajectories.
+	inline uint64_t HashTrajectory(uint64_t Hash, const float* Values, size_t NumValues)
+	{
+		for (size_t Index = 0; Index < NumValues; ++Index)
+		{
+			uint32_t Bits;
+			std::memcpy(&Bits, &Values[Index], sizeof(Bits));
+			for (auto Byte = 0; Byte < 4; ++Byte)
+			{
+				Hash ^= (Bits >> (Byte * 8)) & 0xFF;
+				Hash *= 1099511628211ull;
+			}
+		}
+
+		return Hash;
+	}
+
+	const uint64_t TrajectoryHashSeed = 14695981039346656037ull;
+}
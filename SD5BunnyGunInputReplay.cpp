@@ -0,0 +1,275 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGun.h"
+#include "SD5BunnyGunInputReplay.h"
+#include "SD5BunnyGunCharacter.h"
+#include "SD5BunnyGunCharacterMovement.h"
+
+// Log category for the input recorder & replayer.
+DEFINE_LOG_CATEGORY_STATIC(LogSD5BunnyGunInputReplay, Log, All);
+
+FSD5BunnyGunInputReplayResult::FSD5BunnyGunInputReplayResult() :
+TrajectoryHash(SD5BunnyGunInputRecording::TrajectoryHashSeed),
+Seconds(0.0)
+{ }
+
+FString FSD5BunnyGunInputReplay::GetRecordingPath(const FString& Filename)
+{
+	return (FPaths::IsRelative(Filename) ? FPaths::Combine(*FPaths::GameSavedDir(), *Filename) : Filename);
+}
+
+bool FSD5BunnyGunInputReplay::StartRecording(ASD5BunnyGunCharacter* Character, float FixedDeltaTime)
+{
+	if (Character == nullptr || FixedDeltaTime <= 0.0f)
+	{
+		return false;
+	}
+
+	const auto Location = Character->GetActorLocation();
+
+	Character->InputRecording = MakeShareable(new SD5BunnyGunInputRecording::FInputRecording());
+	Character->InputRecording->FixedDeltaTime = FixedDeltaTime;
+	Character->InputRecording->StartLocation[0] = Location.X;
+	Character->InputRecording->StartLocation[1] = Location.Y;
+	Character->InputRecording->StartLocation[2] = Location.Z;
+	Character->InputRecording->StartYaw = Character->GetActorRotation().Yaw;
+
+	return true;
+}
+
+bool FSD5BunnyGunInputReplay::StopRecording(ASD5BunnyGunCharacter* Character, const FString& Filename)
+{
+	if (Character == nullptr || !Character->InputRecording.IsValid())
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> Data;
+	SD5BunnyGunInputRecording::WriteInputRecording(*Character->InputRecording, Data);
+	Character->InputRecording.Reset();
+
+	TArray<uint8> Bytes;
+	Bytes.Append(Data.data(), Data.size());
+
+	return FFileHelper::SaveArrayToFile(Bytes, *GetRecordingPath(Filename));
+}
+
+bool FSD5BunnyGunInputReplay::LoadRecording(const FString& Filename, SD5BunnyGunInputRecording::FInputRecording& OutRecording)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *GetRecordingPath(Filename)))
+	{
+		return false;
+	}
+
+	return SD5BunnyGunInputRecording::ReadInputRecording(Bytes.GetData(), Bytes.Num(), OutRecording);
+}
+
+bool FSD5BunnyGunInputReplay::Replay(UWorld* World, const SD5BunnyGunInputRecording::FInputRecording& Recording, bool bKeepTrajectory, FSD5BunnyGunInputReplayResult& OutResult)
+{
+	if (World == nullptr)
+	{
+		return false;
+	}
+
+	// Use the game's pawn class if it is a Bunny Gun character so that we get the same capsule & tuning.
+	UClass* CharacterClass = ASD5BunnyGunCharacter::StaticClass();
+	const auto GameMode = World->GetAuthGameMode();
+	if (GameMode != nullptr && GameMode->DefaultPawnClass != nullptr && GameMode->DefaultPawnClass->IsChildOf(ASD5BunnyGunCharacter::StaticClass()))
+	{
+		CharacterClass = GameMode->DefaultPawnClass;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.bNoCollisionFail = true;
+
+	const auto StartLocation = FVector(Recording.StartLocation[0], Recording.StartLocation[1], Recording.StartLocation[2]);
+	const auto Character = World->SpawnActor<ASD5BunnyGunCharacter>(CharacterClass, StartLocation, FRotator(0.0f, Recording.StartYaw, 0.0f), SpawnParams);
+	if (Character == nullptr)
+	{
+		return false;
+	}
+
+	const auto MoveComponent = static_cast<USD5BunnyGunCharacterMovement*>(Character->GetCharacterMovement());
+
+	// We drive the character ourselves at the fixed timestep, so stop the engine from ticking it.
+	Character->SetActorTickEnabled(false);
+	Character->bCanBeDamaged = false;
+	MoveComponent->SetComponentTickEnabled(false);
+	MoveComponent->bRunPhysicsWithNoController = true;
+	MoveComponent->bUseSimulatedTime = true;
+	MoveComponent->SimulatedTimeSeconds = 0.0f;
+
+	const auto DeltaTime = Recording.FixedDeltaTime;
+	const auto NumFrames = static_cast<int32>(Recording.Frames.size());
+	if (bKeepTrajectory)
+	{
+		OutResult.Locations.Reset(NumFrames);
+		OutResult.Velocities.Reset(NumFrames);
+	}
+
+	SD5BunnyGunInputRecording::FInputState LastState;
+	OutResult.TrajectoryHash = SD5BunnyGunInputRecording::TrajectoryHashSeed;
+
+	const auto StartTime = FPlatformTime::Seconds();
+	for (const auto& Frame : Recording.Frames)
+	{
+		const auto State = SD5BunnyGunInputRecording::DequantizeInputFrame(Frame);
+		MoveComponent->SimulatedTimeSeconds += DeltaTime;
+
+		// There is no controller, so apply the recorded view directly.
+		Character->SetActorRotation(FRotator(0.0f, State.Yaw, 0.0f));
+		Character->LookRotation = FRotator(State.Pitch, State.Yaw, 0.0f);
+
+		// Buttons are replayed as press & release events, exactly like the input bindings.
+		if (State.bJump && !LastState.bJump)
+		{
+			Character->StartJumping();
+		}
+		else if (!State.bJump && LastState.bJump)
+		{
+			Character->StopJumping();
+		}
+
+		if (State.bCrouch && !LastState.bCrouch)
+		{
+			Character->StartCrouching();
+		}
+		else if (!State.bCrouch && LastState.bCrouch)
+		{
+			Character->StopCrouching();
+		}
+
+		if (State.bSlowWalk && !LastState.bSlowWalk)
+		{
+			Character->StartSlowWalking();
+		}
+		else if (!State.bSlowWalk && LastState.bSlowWalk)
+		{
+			Character->StopSlowWalking();
+		}
+
+		Character->MoveForward(State.MoveForward);
+		Character->MoveRight(State.MoveRight);
+		LastState = State;
+
+		MoveComponent->TickComponent(DeltaTime, LEVELTICK_All, &MoveComponent->PrimaryComponentTick);
+
+		const auto Location = Character->GetActorLocation();
+		const auto Velocity = MoveComponent->Velocity;
+		const float Values[] = { Location.X, Location.Y, Location.Z, Velocity.X, Velocity.Y, Velocity.Z };
+		OutResult.TrajectoryHash = SD5BunnyGunInputRecording::HashTrajectory(OutResult.TrajectoryHash, Values, ARRAY_COUNT(Values));
+
+		if (bKeepTrajectory)
+		{
+			OutResult.Locations.Add(Location);
+			OutResult.Velocities.Add(Velocity);
+		}
+	}
+	OutResult.Seconds = FPlatformTime::Seconds() - StartTime;
+
+	Character->Destroy();
+	return true;
+}
+
+// Returns the character of the first player in the world.
+static ASD5BunnyGunCharacter* GetFirstPlayerCharacter(UWorld* World)
+{
+	const auto PlayerController = (World != nullptr ? World->GetFirstPlayerController() : nullptr);
+	return (PlayerController != nullptr ? Cast<ASD5BunnyGunCharacter>(PlayerController->GetPawn()) : nullptr);
+}
+
+static void HandleRecordInputCommand(const TArray<FString>& Args, UWorld* World)
+{
+	const auto FixedDeltaTime = (Args.Num() > 0 ? FCString::Atof(*Args[0]) : (1.0f / 60.0f));
+	if (!FSD5BunnyGunInputReplay::StartRecording(GetFirstPlayerCharacter(World), FixedDeltaTime))
+	{
+		UE_LOG(LogSD5BunnyGunInputReplay, Warning, TEXT("BunnyGun.RecordInput: no Bunny Gun character to record!"));
+		return;
+	}
+
+	UE_LOG(LogSD5BunnyGunInputReplay, Log, TEXT("Recording input at a fixed timestep of %f seconds."), FixedDeltaTime);
+}
+
+static void HandleStopRecordInputCommand(const TArray<FString>& Args, UWorld* World)
+{
+	const auto Filename = (Args.Num() > 0 ? Args[0] : FString(TEXT("InputRecording.bgir")));
+	if (!FSD5BunnyGunInputReplay::StopRecording(GetFirstPlayerCharacter(World), Filename))
+	{
+		UE_LOG(LogSD5BunnyGunInputReplay, Warning, TEXT("BunnyGun.StopRecordInput: could not save recording to %s!"), *FSD5BunnyGunInputReplay::GetRecordingPath(Filename));
+		return;
+	}
+
+	UE_LOG(LogSD5BunnyGunInputReplay, Log, TEXT("Saved input recording to %s."), *FSD5BunnyGunInputReplay::GetRecordingPath(Filename));
+}
+
+static void HandleReplayInputCommand(const TArray<FString>& Args, UWorld* World)
+{
+	if (Args.Num() < 1)
+	{
+		UE_LOG(LogSD5BunnyGunInputReplay, Warning, TEXT("Usage: BunnyGun.ReplayInput <File> [Runs] [CsvFile]"));
+		return;
+	}
+
+	SD5BunnyGunInputRecording::FInputRecording Recording;
+	if (!FSD5BunnyGunInputReplay::LoadRecording(Args[0], Recording))
+	{
+		UE_LOG(LogSD5BunnyGunInputReplay, Warning, TEXT("BunnyGun.ReplayInput: could not load recording %s!"), *FSD5BunnyGunInputReplay::GetRecordingPath(Args[0]));
+		return;
+	}
+
+	const auto NumRuns = FMath::Max(1, (Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 2));
+	const auto bWriteCsv = Args.Num() > 2;
+
+	auto bIdentical = true;
+	auto FirstHash = uint64(0);
+	FSD5BunnyGunInputReplayResult Result;
+	for (auto Run = 0; Run < NumRuns; ++Run)
+	{
+		if (!FSD5BunnyGunInputReplay::Replay(World, Recording, bWriteCsv && Run == NumRuns - 1, Result))
+		{
+			UE_LOG(LogSD5BunnyGunInputReplay, Warning, TEXT("BunnyGun.ReplayInput: could not spawn a character to replay with!"));
+			return;
+		}
+
+		FirstHash = (Run == 0 ? Result.TrajectoryHash : FirstHash);
+		bIdentical = bIdentical && Result.TrajectoryHash == FirstHash;
+
+		const auto NumFrames = FMath::Max<int32>(1, Recording.Frames.size());
+		UE_LOG(LogSD5BunnyGunInputReplay, Log, TEXT("Replay %d: %d frames in %.3f ms (%.3f us/frame), trajectory hash %016llx"),
+			Run, static_cast<int32>(Recording.Frames.size()), Result.Seconds * 1000.0, (Result.Seconds * 1000000.0) / NumFrames, Result.TrajectoryHash);
+	}
+
+	if (!bIdentical)
+	{
+		UE_LOG(LogSD5BunnyGunInputReplay, Error, TEXT("BunnyGun.ReplayInput: replays of %s produced different trajectories!"), *Args[0]);
+	}
+
+	if (bWriteCsv)
+	{
+		FString Csv = TEXT("Frame,LocationX,LocationY,LocationZ,VelocityX,VelocityY,VelocityZ\n");
+		for (auto Index = 0; Index < Result.Locations.Num(); ++Index)
+		{
+			const auto& Location = Result.Locations[Index];
+			const auto& Velocity = Result.Velocities[Index];
+			Csv += FString::Printf(TEXT("%d,%f,%f,%f,%f,%f,%f\n"), Index, Location.X, Location.Y, Location.Z, Velocity.X, Velocity.Y, Velocity.Z);
+		}
+
+		FFileHelper::SaveStringToFile(Csv, *FSD5BunnyGunInputReplay::GetRecordingPath(Args[2]));
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs RecordInputCommand(
+	TEXT("BunnyGun.RecordInput"),
+	TEXT("Starts recording the input of the first player's character. Usage: BunnyGun.RecordInput [FixedDeltaTime]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&HandleRecordInputCommand));
+
+static FAutoConsoleCommandWithWorldAndArgs StopRecordInputCommand(
+	TEXT("BunnyGun.StopRecordInput"),
+	TEXT("Stops recording input and saves it. Usage: BunnyGun.StopRecordInput <File>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&HandleStopRecordInputCommand));
+
+static FAutoConsoleCommandWithWorldAndArgs ReplayInputCommand(
+	TEXT("BunnyGun.ReplayInput"),
+	TEXT("Replays an input recording at its fixed timestep and checks the trajectories are identical. Usage: BunnyGun.ReplayInput <File> [Runs] [CsvFile]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&HandleReplayInputCommand));
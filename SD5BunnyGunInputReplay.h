@@ -0,0 +1,54 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+#include "SD5BunnyGunInputRecording.h"
+
+class ASD5BunnyGunCharacter;
+
+/**
+ * The outcome of replaying an input recording.
+ */
+struct FSD5BunnyGunInputReplayResult
+{
+	// Hash of the location & velocity of every frame. Equal hashes mean identical trajectories.
+	uint64 TrajectoryHash;
+
+	// Wall clock time spent ticking the movement.
+	double Seconds;
+
+	// Location & velocity of every frame (only filled in if requested).
+	TArray<FVector> Locations;
+	TArray<FVector> Velocities;
+
+	FSD5BunnyGunInputReplayResult();
+};
+
+/**
+ * Records the per-tick input of a Bunny Gun character & replays it through USD5BunnyGunCharacterMovement at a fixed timestep,
+ * independent of the frame rate. This gives a repeatable workload for profiling CalcVelocity() & DoJump() outside of a live session.
+ *
+ * Console commands (also usable from a -nullrhi dedicated server via -ExecCmds):
+ *   BunnyGun.RecordInput [FixedDeltaTime]        Starts recording the first player's character.
+ *   BunnyGun.StopRecordInput <File>              Stops recording & saves it (relative to the Saved directory).
+ *   BunnyGun.ReplayInput <File> [Runs] [CsvFile] Replays a recording Runs times (default 2), logs the timing & trajectory hash of each run
+ *                                                and optionally writes the trajectory of the last run to a CSV file.
+ */
+class SD5BUNNYGUN_API FSD5BunnyGunInputReplay
+{
+public:
+	// Starts recording the input of a character every tick.
+	static bool StartRecording(ASD5BunnyGunCharacter* Character, float FixedDeltaTime);
+
+	// Stops recording the input of a character and saves the recording to a file.
+	static bool StopRecording(ASD5BunnyGunCharacter* Character, const FString& Filename);
+
+	// Loads a recording from a file.
+	static bool LoadRecording(const FString& Filename, SD5BunnyGunInputRecording::FInputRecording& OutRecording);
+
+	// Spawns a character, feeds it the recorded input one fixed timestep at a time and destroys it again.
+	static bool Replay(UWorld* World, const SD5BunnyGunInputRecording::FInputRecording& Recording, bool bKeepTrajectory, FSD5BunnyGunInputReplayResult& OutResult);
+
+	// Resolves a file name relative to the Saved directory.
+	static FString GetRecordingPath(const FString& Filename);
+};
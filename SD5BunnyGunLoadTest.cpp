@@ -0,0 +1,560 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGun.h"
+#include "SD5BunnyGunLoadTest.h"
+#include "SD5BunnyGunBotController.h"
+#include "SD5BunnyGunCharacter.h"
+#include "SD5BunnyGunCharacterPool.h"
+#include "SD5BunnyGunFloorCache.h"
+#include "EngineUtils.h"
+
+// Log category for the load test.
+DEFINE_LOG_CATEGORY_STATIC(LogSD5BunnyGunLoadTest, Log, All);
+
+FSD5BunnyGunLoadTestStepResult::FSD5BunnyGunLoadTestStepResult() :
+NumBots(0),
+NumFrames(0),
+FrameMsP50(0.0f),
+FrameMsP95(0.0f),
+FrameMsP99(0.0f),
+BusyMsP50(0.0f),
+BusyMsP95(0.0f),
+BusyMsP99(0.0f),
+CpuUsPerBot(0.0f),
+OutBytesPerClientPerSecond(0.0f),
+NumClients(0),
+NumKills(0),
+NumRespawns(0),
+NumCharactersSpawned(0),
+RespawnsPerSecond(0.0f),
+RespawnUs(0.0f),
+ObjectsCreatedPerSecond(0.0f),
+FloorCacheHitRate(0.0f),
+FloorQueryMsSavedPerSecond(0.0f),
+BytesPerCharacter(0)
+{ }
+
+namespace
+{
+	// Time that every step runs for before it is measured, so that the bots are spread out & moving.
+	const float LoadTestWarmupSeconds = 5.0f;
+
+	// Time that a killed bot waits before respawning.
+	const float LoadTestRespawnSeconds = 2.0f;
+
+	// Distance from their home location that bots are spawned within.
+	const float LoadTestSpawnRadius = 500.0f;
+
+	// A bot & the time it will respawn at if it is dead (0 if it is alive).
+	struct FLoadTestBot
+	{
+		TWeakObjectPtr<ASD5BunnyGunBotController> Controller;
+		FVector HomeLocation;
+		float RespawnTime;
+	};
+
+	// Counts the UObjects created while the load test is running.
+	struct FLoadTestObjectCounter : public FUObjectArray::FUObjectCreateListener
+	{
+		// NOTE: Objects can also be created by the async loading thread.
+		FThreadSafeCounter NumCreated;
+
+		void NotifyUObjectCreated(const UObjectBase* Object, int32 Index) override
+		{
+			NumCreated.Increment();
+		}
+	};
+
+	struct FLoadTestState
+	{
+		bool bIsRunning;
+		TWeakObjectPtr<UWorld> World;
+		TArray<int32> BotCounts;
+		float SecondsPerStep;
+		FString Path;
+		FDelegateHandle TickerHandle;
+
+		// Index of the current step into BotCounts, or -1 for the baseline step without bots.
+		int32 StepIndex;
+		float StepTime;
+		float Time;
+
+		TArray<float> FrameMs;
+		TArray<float> BusyMs;
+		double OutBytesPerClientSum;
+		int32 NumOutBytesSamples;
+		int32 NumClients;
+		int32 KillsAtStepStart;
+		float BaselineBusyMs;
+
+		// Measured after the warm up.
+		int32 NumRespawns;
+		int32 NumCharactersSpawned;
+		double RespawnSeconds;
+		int32 ObjectsCreatedAtWarmupEnd;
+
+		TArray<FLoadTestBot> Bots;
+		TArray<FVector> SpawnLocations;
+		FRandomStream SpawnStream;
+		TArray<FSD5BunnyGunLoadTestStepResult> Results;
+
+		FLoadTestState() : bIsRunning(false), SecondsPerStep(0.0f), StepIndex(-1), StepTime(0.0f), Time(0.0f), OutBytesPerClientSum(0.0),
+			NumOutBytesSamples(0), NumClients(0), KillsAtStepStart(0), BaselineBusyMs(0.0f), NumRespawns(0), NumCharactersSpawned(0),
+			RespawnSeconds(0.0), ObjectsCreatedAtWarmupEnd(0) { }
+	};
+
+	FLoadTestState State;
+	FLoadTestObjectCounter ObjectCounter;
+
+	// Returns the value that Percentile of the sorted values are at or below.
+	float GetPercentile(const TArray<float>& SortedValues, float Percentile)
+	{
+		if (SortedValues.Num() == 0)
+		{
+			return 0.0f;
+		}
+
+		return SortedValues[FMath::Min(SortedValues.Num() - 1, FMath::FloorToInt(Percentile * SortedValues.Num()))];
+	}
+
+	float GetAverage(const TArray<float>& Values)
+	{
+		auto Sum = 0.0;
+		for (const auto Value : Values)
+		{
+			Sum += Value;
+		}
+
+		return (Values.Num() > 0 ? static_cast<float>(Sum / Values.Num()) : 0.0f);
+	}
+
+	int32 GetTotalKills()
+	{
+		auto Kills = 0;
+		for (const auto& Bot : State.Bots)
+		{
+			Kills += (Bot.Controller.IsValid() ? Bot.Controller->Kills : 0);
+		}
+
+		return Kills;
+	}
+
+	// Returns the time of a server tick in ms.
+	float GetServerTickMs(UWorld* World)
+	{
+		const auto NetDriver = World->GetNetDriver();
+		const auto TickRate = (NetDriver != nullptr && NetDriver->NetServerMaxTickRate > 0 ? NetDriver->NetServerMaxTickRate : 30);
+
+		return 1000.0f / TickRate;
+	}
+
+	// Spawns a character for a bot near its home location & possesses it.
+	bool SpawnBotCharacter(UWorld* World, FLoadTestBot& Bot)
+	{
+		// Use the game's pawn class if it is a Bunny Gun character so that we get the same capsule, mesh & tuning.
+		UClass* CharacterClass = ASD5BunnyGunCharacter::StaticClass();
+		const auto GameMode = World->GetAuthGameMode();
+		if (GameMode != nullptr && GameMode->DefaultPawnClass != nullptr && GameMode->DefaultPawnClass->IsChildOf(ASD5BunnyGunCharacter::StaticClass()))
+		{
+			CharacterClass = GameMode->DefaultPawnClass;
+		}
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.bNoCollisionFail = true;
+
+		const auto Offset = FVector(State.SpawnStream.FRandRange(-1.0f, 1.0f), State.SpawnStream.FRandRange(-1.0f, 1.0f), 0.0f) * LoadTestSpawnRadius;
+		const auto Rotation = FRotator(0.0f, State.SpawnStream.FRandRange(0.0f, 360.0f), 0.0f);
+		const auto StartSeconds = FPlatformTime::Seconds();
+		auto bWasReused = false;
+		const auto Character = FSD5BunnyGunCharacterPool::SpawnCharacter(World, CharacterClass, Bot.HomeLocation + Offset, Rotation, SpawnParams, bWasReused);
+		if (Character == nullptr)
+		{
+			return false;
+		}
+
+		Bot.Controller->Possess(Character);
+
+		// Only the respawns of killed bots are measured, not the bots spawned by a new step.
+		if (Bot.RespawnTime > 0.0f && State.StepTime >= LoadTestWarmupSeconds)
+		{
+			++State.NumRespawns;
+			State.NumCharactersSpawned += (bWasReused ? 0 : 1);
+			State.RespawnSeconds += FPlatformTime::Seconds() - StartSeconds;
+		}
+
+		Bot.RespawnTime = 0.0f;
+		return true;
+	}
+
+	bool SpawnBot(UWorld* World)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.bNoCollisionFail = true;
+
+		FLoadTestBot Bot;
+		Bot.Controller = World->SpawnActor<ASD5BunnyGunBotController>(SpawnParams);
+		if (!Bot.Controller.IsValid())
+		{
+			return false;
+		}
+
+		const auto BotIndex = State.Bots.Num();
+		Bot.HomeLocation = State.SpawnLocations[BotIndex % State.SpawnLocations.Num()];
+		Bot.RespawnTime = 0.0f;
+		Bot.Controller->InitBot(BotIndex, Bot.HomeLocation);
+
+		State.Bots.Add(Bot);
+		return SpawnBotCharacter(World, State.Bots.Last());
+	}
+
+	void DestroyBot(FLoadTestBot& Bot)
+	{
+		if (!Bot.Controller.IsValid())
+		{
+			return;
+		}
+
+		const auto Pawn = Bot.Controller->GetPawn();
+		if (Pawn != nullptr)
+		{
+			Pawn->Destroy();
+		}
+
+		Bot.Controller->Destroy();
+	}
+
+	// Spawns or destroys bots so that there are NumBots of them & resets the measurements for a new step.
+	void StartStep(UWorld* World, int32 NumBots)
+	{
+		while (State.Bots.Num() > NumBots)
+		{
+			DestroyBot(State.Bots.Last());
+			State.Bots.Pop();
+		}
+
+		while (State.Bots.Num() < NumBots)
+		{
+			if (!SpawnBot(World))
+			{
+				UE_LOG(LogSD5BunnyGunLoadTest, Warning, TEXT("BunnyGun.LoadTest: could not spawn a bot!"));
+				break;
+			}
+		}
+
+		State.StepTime = 0.0f;
+		State.FrameMs.Reset();
+		State.BusyMs.Reset();
+		State.OutBytesPerClientSum = 0.0;
+		State.NumOutBytesSamples = 0;
+		State.NumClients = 0;
+		State.KillsAtStepStart = GetTotalKills();
+		State.NumRespawns = 0;
+		State.NumCharactersSpawned = 0;
+		State.RespawnSeconds = 0.0;
+
+		UE_LOG(LogSD5BunnyGunLoadTest, Log, TEXT("Load test step with %d bots."), State.Bots.Num());
+	}
+
+	// Respawns killed bots once they have waited long enough.
+	void RespawnBots(UWorld* World)
+	{
+		for (auto& Bot : State.Bots)
+		{
+			if (!Bot.Controller.IsValid())
+			{
+				continue;
+			}
+
+			const auto Character = Cast<ASD5BunnyGunCharacter>(Bot.Controller->GetPawn());
+			if (Character != nullptr && Character->IsAlive())
+			{
+				continue;
+			}
+
+			if (Bot.RespawnTime <= 0.0f)
+			{
+				Bot.RespawnTime = State.Time + LoadTestRespawnSeconds;
+			}
+			else if (State.Time >= Bot.RespawnTime)
+			{
+				SpawnBotCharacter(World, Bot);
+			}
+		}
+	}
+
+	// Samples the frame that just finished.
+	void SampleFrame(UWorld* World)
+	{
+		if (State.FrameMs.Num() == 0)
+		{
+			State.ObjectsCreatedAtWarmupEnd = ObjectCounter.NumCreated.GetValue();
+			FSD5BunnyGunFloorCache::ResetStats(World);
+		}
+
+		const auto FrameMs = static_cast<float>(FApp::GetDeltaTime() * 1000.0);
+		State.FrameMs.Add(FrameMs);
+		State.BusyMs.Add(FMath::Max(0.0f, FrameMs - static_cast<float>(FApp::GetIdleTime() * 1000.0)));
+
+		const auto NetDriver = World->GetNetDriver();
+		if (NetDriver != nullptr && NetDriver->ClientConnections.Num() > 0)
+		{
+			auto OutBytesPerSecond = 0.0;
+			for (const auto Connection : NetDriver->ClientConnections)
+			{
+				OutBytesPerSecond += Connection->OutBytesPerSecond;
+			}
+
+			State.OutBytesPerClientSum += OutBytesPerSecond / NetDriver->ClientConnections.Num();
+			++State.NumOutBytesSamples;
+			State.NumClients = FMath::Max(State.NumClients, NetDriver->ClientConnections.Num());
+		}
+	}
+
+	FSD5BunnyGunLoadTestStepResult FinishStep(UWorld* World)
+	{
+		FSD5BunnyGunLoadTestStepResult Result;
+		Result.NumBots = State.Bots.Num();
+		Result.NumFrames = State.FrameMs.Num();
+
+		const auto AverageBusyMs = GetAverage(State.BusyMs);
+		State.FrameMs.Sort();
+		State.BusyMs.Sort();
+
+		Result.FrameMsP50 = GetPercentile(State.FrameMs, 0.5f);
+		Result.FrameMsP95 = GetPercentile(State.FrameMs, 0.95f);
+		Result.FrameMsP99 = GetPercentile(State.FrameMs, 0.99f);
+		Result.BusyMsP50 = GetPercentile(State.BusyMs, 0.5f);
+		Result.BusyMsP95 = GetPercentile(State.BusyMs, 0.95f);
+		Result.BusyMsP99 = GetPercentile(State.BusyMs, 0.99f);
+		Result.CpuUsPerBot = (Result.NumBots > 0 ? ((AverageBusyMs - State.BaselineBusyMs) * 1000.0f) / Result.NumBots : 0.0f);
+		Result.OutBytesPerClientPerSecond = (State.NumOutBytesSamples > 0 ? static_cast<float>(State.OutBytesPerClientSum / State.NumOutBytesSamples) : 0.0f);
+		Result.NumClients = State.NumClients;
+		Result.NumKills = GetTotalKills() - State.KillsAtStepStart;
+
+		const auto MeasuredSeconds = FMath::Max(State.StepTime - LoadTestWarmupSeconds, KINDA_SMALL_NUMBER);
+		Result.NumRespawns = State.NumRespawns;
+		Result.NumCharactersSpawned = State.NumCharactersSpawned;
+		Result.RespawnsPerSecond = State.NumRespawns / MeasuredSeconds;
+		Result.RespawnUs = (State.NumRespawns > 0 ? static_cast<float>((State.RespawnSeconds * 1.e6) / State.NumRespawns) : 0.0f);
+		Result.ObjectsCreatedPerSecond = (ObjectCounter.NumCreated.GetValue() - State.ObjectsCreatedAtWarmupEnd) / MeasuredSeconds;
+
+		const auto FloorCacheStats = FSD5BunnyGunFloorCache::GetStats(World);
+		Result.FloorCacheHitRate = FloorCacheStats.GetHitRate();
+		Result.FloorQueryMsSavedPerSecond = FloorCacheStats.SavedMs / MeasuredSeconds;
+
+		// NOTE: Every bot has the same class, so the first one with a character is measured.
+		for (const auto& Bot : State.Bots)
+		{
+			const auto Character = (Bot.Controller.IsValid() ? Cast<ASD5BunnyGunCharacter>(Bot.Controller->GetPawn()) : nullptr);
+			if (Character != nullptr)
+			{
+				Result.BytesPerCharacter = Character->GetInstanceBytes();
+				break;
+			}
+		}
+
+		if (State.StepIndex < 0)
+		{
+			State.BaselineBusyMs = AverageBusyMs;
+		}
+
+		UE_LOG(LogSD5BunnyGunLoadTest, Log, TEXT("%d bots: frame p50/p95/p99 %.2f/%.2f/%.2f ms, busy p50/p95/p99 %.2f/%.2f/%.2f ms, %.1f us per bot, %.0f bytes/s per client (%d clients), %d kills."),
+			Result.NumBots, Result.FrameMsP50, Result.FrameMsP95, Result.FrameMsP99, Result.BusyMsP50, Result.BusyMsP95, Result.BusyMsP99,
+			Result.CpuUsPerBot, Result.OutBytesPerClientPerSecond, Result.NumClients, Result.NumKills);
+		UE_LOG(LogSD5BunnyGunLoadTest, Log, TEXT("%d bots: %.1f respawns/s (%d of %d spawned a new character), %.1f us per respawn, %.0f UObjects created/s."),
+			Result.NumBots, Result.RespawnsPerSecond, Result.NumCharactersSpawned, Result.NumRespawns, Result.RespawnUs, Result.ObjectsCreatedPerSecond);
+		UE_LOG(LogSD5BunnyGunLoadTest, Log, TEXT("%d bots: floor cache hit rate %.1f%% (%d lookups), %.3f ms of floor queries saved per second."),
+			Result.NumBots, Result.FloorCacheHitRate * 100.0f, FloorCacheStats.NumLookups, Result.FloorQueryMsSavedPerSecond);
+		UE_LOG(LogSD5BunnyGunLoadTest, Log, TEXT("%d bots: %d bytes per character (%.1f KB for every bot)."),
+			Result.NumBots, Result.BytesPerCharacter, (Result.BytesPerCharacter * Result.NumBots) / 1024.0f);
+
+		return Result;
+	}
+
+	// Destroys the bots & forgets about the load test.
+	void ResetLoadTest()
+	{
+		for (auto& Bot : State.Bots)
+		{
+			DestroyBot(Bot);
+		}
+
+		// The bodies of the killed bots.
+		if (State.World.IsValid())
+		{
+			FSD5BunnyGunCharacterPool::DestroyPooledCharacters(State.World.Get());
+		}
+
+		GUObjectArray.RemoveUObjectCreateListener(&ObjectCounter);
+		State = FLoadTestState();
+	}
+
+	// Logs the capacity & saves the results.
+	void FinishLoadTest(UWorld* World)
+	{
+		const auto TickMs = GetServerTickMs(World);
+		auto Capacity = 0;
+		for (const auto& Result : State.Results)
+		{
+			Capacity = (Result.BusyMsP99 <= TickMs ? FMath::Max(Capacity, Result.NumBots) : Capacity);
+		}
+
+		UE_LOG(LogSD5BunnyGunLoadTest, Log, TEXT("Load test capacity: %d bots within a %.2f ms server tick (99th percentile busy time)."), Capacity, TickMs);
+
+		if (!FFileHelper::SaveStringToFile(FSD5BunnyGunLoadTest::ToCsv(State.Results), *State.Path))
+		{
+			UE_LOG(LogSD5BunnyGunLoadTest, Warning, TEXT("BunnyGun.LoadTest: could not write %s!"), *State.Path);
+		}
+		else
+		{
+			UE_LOG(LogSD5BunnyGunLoadTest, Log, TEXT("Saved load test results to %s."), *State.Path);
+		}
+
+		ResetLoadTest();
+	}
+
+	bool TickLoadTest(float DeltaTime)
+	{
+		const auto World = State.World.Get();
+		if (World == nullptr)
+		{
+			ResetLoadTest();
+			return false;
+		}
+
+		State.Time += DeltaTime;
+		State.StepTime += DeltaTime;
+		RespawnBots(World);
+
+		if (State.StepTime >= LoadTestWarmupSeconds)
+		{
+			SampleFrame(World);
+		}
+
+		// The baseline only needs long enough to get a stable average.
+		const auto StepSeconds = (State.StepIndex < 0 ? FMath::Min(State.SecondsPerStep, 10.0f) : State.SecondsPerStep);
+		if (State.StepTime < LoadTestWarmupSeconds + StepSeconds)
+		{
+			return true;
+		}
+
+		const auto Result = FinishStep(World);
+		if (State.StepIndex >= 0)
+		{
+			State.Results.Add(Result);
+		}
+
+		if (++State.StepIndex >= State.BotCounts.Num())
+		{
+			FinishLoadTest(World);
+			return false;
+		}
+
+		StartStep(World, State.BotCounts[State.StepIndex]);
+		return true;
+	}
+}
+
+bool FSD5BunnyGunLoadTest::Start(UWorld* World, const TArray<int32>& BotCounts, float SecondsPerStep, const FString& Filename)
+{
+	// Only the server can spawn the bots.
+	if (World == nullptr || World->GetAuthGameMode() == nullptr || BotCounts.Num() == 0 || SecondsPerStep <= 0.0f)
+	{
+		return false;
+	}
+
+	Stop();
+
+	State.bIsRunning = true;
+	State.World = World;
+	State.BotCounts = BotCounts;
+	State.SecondsPerStep = SecondsPerStep;
+	State.Path = (FPaths::IsRelative(Filename) ? FPaths::Combine(*FPaths::GameSavedDir(), *Filename) : Filename);
+	State.StepIndex = -1;
+	State.Time = 0.0f;
+	State.BaselineBusyMs = 0.0f;
+	State.SpawnStream.Initialize(0xB6);
+	GUObjectArray.AddUObjectCreateListener(&ObjectCounter);
+
+	// Spread the bots over the player starts.
+	State.SpawnLocations.Reset();
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		State.SpawnLocations.Add(It->GetActorLocation());
+	}
+	if (State.SpawnLocations.Num() == 0)
+	{
+		State.SpawnLocations.Add(FVector(0.0f, 0.0f, 200.0f));
+	}
+
+	StartStep(World, 0);
+	State.TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&TickLoadTest));
+	return true;
+}
+
+void FSD5BunnyGunLoadTest::Stop()
+{
+	if (!State.bIsRunning)
+	{
+		return;
+	}
+
+	FTicker::GetCoreTicker().RemoveTicker(State.TickerHandle);
+	ResetLoadTest();
+}
+
+FString FSD5BunnyGunLoadTest::ToCsv(const TArray<FSD5BunnyGunLoadTestStepResult>& Results)
+{
+	FString Csv = TEXT("Bots,Frames,FrameMsP50,FrameMsP95,FrameMsP99,BusyMsP50,BusyMsP95,BusyMsP99,CpuUsPerBot,OutBytesPerClientPerSecond,Clients,Kills,")
+		TEXT("Respawns,CharactersSpawned,RespawnsPerSecond,RespawnUs,ObjectsCreatedPerSecond,FloorCacheHitRate,FloorQueryMsSavedPerSecond,BytesPerCharacter\n");
+	for (const auto& Result : Results)
+	{
+		Csv += FString::Printf(TEXT("%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.2f,%.0f,%d,%d,%d,%d,%.2f,%.1f,%.0f,%.4f,%.3f,%d\n"), Result.NumBots, Result.NumFrames,
+			Result.FrameMsP50, Result.FrameMsP95, Result.FrameMsP99, Result.BusyMsP50, Result.BusyMsP95, Result.BusyMsP99,
+			Result.CpuUsPerBot, Result.OutBytesPerClientPerSecond, Result.NumClients, Result.NumKills,
+			Result.NumRespawns, Result.NumCharactersSpawned, Result.RespawnsPerSecond, Result.RespawnUs, Result.ObjectsCreatedPerSecond,
+			Result.FloorCacheHitRate, Result.FloorQueryMsSavedPerSecond, Result.BytesPerCharacter);
+	}
+
+	return Csv;
+}
+
+static void HandleLoadTestCommand(const TArray<FString>& Args, UWorld* World)
+{
+	const auto SecondsPerStep = (Args.Num() > 0 ? FCString::Atof(*Args[0]) : 30.0f);
+	const auto Filename = (Args.Num() > 1 ? Args[1] : FString(TEXT("LoadTest.csv")));
+
+	TArray<int32> BotCounts;
+	for (auto Index = 2; Index < Args.Num(); ++Index)
+	{
+		BotCounts.Add(FMath::Max(0, FCString::Atoi(*Args[Index])));
+	}
+	if (BotCounts.Num() == 0)
+	{
+		static const int32 DefaultBotCounts[] = { 16, 64, 128, 256 };
+		BotCounts.Append(DefaultBotCounts, ARRAY_COUNT(DefaultBotCounts));
+	}
+
+	if (!FSD5BunnyGunLoadTest::Start(World, BotCounts, SecondsPerStep, Filename))
+	{
+		UE_LOG(LogSD5BunnyGunLoadTest, Warning, TEXT("BunnyGun.LoadTest: must be run on the server. Usage: BunnyGun.LoadTest [Seconds] [CsvFile] [Bots...]"));
+		return;
+	}
+
+	UE_LOG(LogSD5BunnyGunLoadTest, Log, TEXT("Starting load test with %d steps of %.1f seconds."), BotCounts.Num(), SecondsPerStep);
+}
+
+static void HandleStopLoadTestCommand()
+{
+	FSD5BunnyGunLoadTest::Stop();
+}
+
+static FAutoConsoleCommandWithWorldAndArgs LoadTestCommand(
+	TEXT("BunnyGun.LoadTest"),
+	TEXT("Spawns autohopping bots in steps & measures the server frame time, CPU per bot & bytes per client. Usage: BunnyGun.LoadTest [Seconds] [CsvFile] [Bots...]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&HandleLoadTestCommand));
+
+static FAutoConsoleCommand StopLoadTestCommand(
+	TEXT("BunnyGun.StopLoadTest"),
+	TEXT("Stops the load test and destroys its bots."),
+	FConsoleCommandDelegate::CreateStatic(&HandleStopLoadTestCommand));
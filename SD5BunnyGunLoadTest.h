@@ -0,0 +1,87 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+/**
+ * Results of a single step (bot count) of the load test.
+ */
+struct FSD5BunnyGunLoadTestStepResult
+{
+	int32 NumBots;
+	int32 NumFrames;
+
+	// Frame time (including the time spent waiting for the server tick rate) percentiles, in ms.
+	float FrameMsP50;
+	float FrameMsP95;
+	float FrameMsP99;
+
+	// Busy time (frame time without the wait) percentiles, in ms.
+	float BusyMsP50;
+	float BusyMsP95;
+	float BusyMsP99;
+
+	// Average busy time per bot over the busy time without any bots, in microseconds.
+	float CpuUsPerBot;
+
+	// Average outgoing bytes per second of each client connection.
+	float OutBytesPerClientPerSecond;
+	int32 NumClients;
+
+	// Kills made by the bots during the step.
+	int32 NumKills;
+
+	// Bot respawns after the warm up, and how many of them spawned a new character instead of respawning one from the
+	// pool (see FSD5BunnyGunCharacterPool).
+	int32 NumRespawns;
+	int32 NumCharactersSpawned;
+	float RespawnsPerSecond;
+
+	// Average time taken by a respawn (spawning or respawning the character & possessing it), in microseconds.
+	float RespawnUs;
+
+	// UObjects created per second after the warm up.
+	float ObjectsCreatedPerSecond;
+
+	// Fraction of floor queries found in the floor cache after the warm up, and the estimated floor query time saved by
+	// them per second, in ms (see FSD5BunnyGunFloorCache).
+	float FloorCacheHitRate;
+	float FloorQueryMsSavedPerSecond;
+
+	// Size of a bot's character & its components, in bytes (see ASD5BunnyGunCharacter::GetInstanceBytes()).
+	int32 BytesPerCharacter;
+
+	FSD5BunnyGunLoadTestStepResult();
+};
+
+/**
+ * Load test for dedicated servers. Spawns ASD5BunnyGunBotController bots in steps of increasing bot counts and measures
+ * each step after a warm up: server frame & busy time percentiles, CPU time per bot, outgoing bytes per client connection,
+ * and the respawns per second, time per respawn & UObjects created per second. Killed bots respawn after 2 seconds, so
+ * running it with BunnyGun.CharacterPool 0 (the default) & 1 compares spawning against respawning through the character pool.
+ * The floor cache hit rate & the floor query time it saved are also measured (use BunnyGun.FloorCache 2 to enable it for the bots),
+ * along with the bytes taken by each character.
+ * The capacity is the largest bot count whose 99th percentile busy time fits within a server tick (1 / NetServerMaxTickRate).
+ *
+ * Meant for a GPU-less box, e.g.:
+ *   UE4Editor SD5BunnyGun <Map> -server -nullrhi -log -ExecCmds="BunnyGun.LoadTest"
+ *   UE4Editor SD5BunnyGun 127.0.0.1 -game -nullrhi -nosound (once per loopback client)
+ * Use a map with ramps, so that the bots trimp. Bots are spawned around the player starts.
+ *
+ * Console commands:
+ *   BunnyGun.LoadTest [Seconds] [CsvFile] [Bots...]  Runs each step (default 16 64 128 256 bots) for Seconds (default 30) after a
+ *                                                    5 second warm up, logs the results & saves them to CsvFile (default
+ *                                                    LoadTest.csv, relative to the Saved directory).
+ *   BunnyGun.StopLoadTest                            Stops the load test & destroys the bots.
+ */
+class SD5BUNNYGUN_API FSD5BunnyGunLoadTest
+{
+public:
+	// Starts the load test in World. Restarts it if one is running.
+	static bool Start(UWorld* World, const TArray<int32>& BotCounts, float SecondsPerStep, const FString& Filename);
+
+	// Stops the load test & destroys the bots.
+	static void Stop();
+
+	// Returns the results as CSV, one row per finished step.
+	static FString ToCsv(const TArray<FSD5BunnyGunLoadTestStepResult>& Results);
+};
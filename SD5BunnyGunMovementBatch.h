@@ -0,0 +1,344 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+#include "SD5BunnyGunMovementMath.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BG_MOVEMENT_BATCH_SSE 1
+#include <emmintrin.h>
+#else
+#define BG_MOVEMENT_BATCH_SSE 0
+#endif
+
+#if defined(__AVX2__)
+#define BG_MOVEMENT_BATCH_AVX2 1
+#include <immintrin.h>
+#else
+#define BG_MOVEMENT_BATCH_AVX2 0
+#endif
+
+/**
+ * Structure-of-arrays batch version of the velocity phase of USD5BunnyGunCharacterMovement::CalcVelocity().
+ *
+ * Runs ground friction, ground acceleration, air acceleration and the EnforcedMaxSpeed clamp for many characters
+ * at once, 4 (SSE2) or 8 (AVX2) characters per instruction. The SIMD kernels use the same operations in the same order
+ * as the scalar SD5BunnyGunMovementMath functions (true sqrt & division, no estimates), so the results match
+ * SolveMovementBatchScalar() to within MovementBatchTolerance - in practice they are usually bit-identical,
+ * the tolerance only covers compilers contracting the scalar path into FMAs. Both always use FPreciseMathPolicy.
+ *
+ * NOTE: Experimental reference only - nothing in the game module uses it. USD5BunnyGunCharacterMovement solves one
+ * character at a time inside the engine's per-character movement tick, and SD5BunnyGunMovementBatchBenchmark measures
+ * the SSE2 kernel within run-to-run noise of the scalar path.
+ */
+namespace SD5BunnyGunMovementMath
+{
+	// Max allowed difference between the SIMD & scalar paths, relative to the character's speed (or 1 cm/s, whichever is larger).
+	const float MovementBatchTolerance = 1.e-4f;
+
+	// Per-character movement mode flags of a batch.
+	enum EMovementBatchFlags : uint32_t
+	{
+		// Character is moving on the ground, ground acceleration is applied.
+		MovementBatchFlag_Walking = 1 << 0,
+
+		// Character is in the air, air acceleration is applied.
+		MovementBatchFlag_Falling = 1 << 1,
+
+		// Ground friction is applied (see USD5BunnyGunCharacterMovement::ShouldApplyGroundFriction()).
+		MovementBatchFlag_ApplyFriction = 1 << 2
+	};
+
+	// Tuning values shared by every character of a batch.
+	struct FMovementBatchParams
+	{
+		float DeltaTime;
+		float StopSpeed;
+		float MaxFallAirSpeed;
+		bool bUseEnforcedMaxSpeed;
+		float EnforcedMaxSpeed;
+	};
+
+	// Movement state of N characters, one array per field.
+	struct FMovementBatch
+	{
+		std::vector<float> VelocityX;
+		std::vector<float> VelocityY;
+		std::vector<float> VelocityZ;
+
+		// Normalised direction of the input acceleration.
+		std::vector<float> WishDirectionX;
+		std::vector<float> WishDirectionY;
+		std::vector<float> WishDirectionZ;
+
+		// The max speed of the current movement mode.
+		std::vector<float> WishSpeed;
+
+		// Magnitude of the input acceleration.
+		std::vector<float> Acceleration;
+
+		// Ground friction of the character.
+		std::vector<float> Friction;
+
+		// EMovementBatchFlags.
+		std::vector<uint32_t> Flags;
+
+		size_t Num() const
+		{
+			return Flags.size();
+		}
+
+		void SetNum(size_t NewNum)
+		{
+			VelocityX.resize(NewNum, 0.0f);
+			VelocityY.resize(NewNum, 0.0f);
+			VelocityZ.resize(NewNum, 0.0f);
+			WishDirectionX.resize(NewNum, 0.0f);
+			WishDirectionY.resize(NewNum, 0.0f);
+			WishDirectionZ.resize(NewNum, 0.0f);
+			WishSpeed.resize(NewNum, 0.0f);
+			Acceleration.resize(NewNum, 0.0f);
+			Friction.resize(NewNum, 0.0f);
+			Flags.resize(NewNum, 0);
+		}
+	};
+
+	namespace MovementBatchDetail
+	{
+		struct FBatchVector
+		{
+			float X;
+			float Y;
+			float Z;
+
+			FBatchVector(float InX, float InY, float InZ) : X(InX), Y(InY), Z(InZ) { }
+		};
+
+		// Solves a single character of the batch with the scalar math.
+		inline void SolveScalar(FMovementBatch& Batch, const FMovementBatchParams& Params, size_t Index)
+		{
+			auto Velocity = FBatchVector(Batch.VelocityX[Index], Batch.VelocityY[Index], Batch.VelocityZ[Index]);
+			const auto WishDirection = FBatchVector(Batch.WishDirectionX[Index], Batch.WishDirectionY[Index], Batch.WishDirectionZ[Index]);
+			const auto Flags = Batch.Flags[Index];
+
+			if (Flags & MovementBatchFlag_ApplyFriction)
+			{
+				ApplyFriction<FPreciseMathPolicy>(Velocity, Params.DeltaTime, Batch.Friction[Index], 1.0f, Params.StopSpeed);
+			}
+
+			if (Flags & MovementBatchFlag_Walking)
+			{
+				ApplyAcceleration(Velocity, Params.DeltaTime, 1.0f, WishDirection, Batch.WishSpeed[Index], Batch.Acceleration[Index]);
+			}
+			else if (Flags & MovementBatchFlag_Falling)
+			{
+				ApplyAirAcceleration(Velocity, Params.DeltaTime, 1.0f, WishDirection, Batch.WishSpeed[Index], Params.MaxFallAirSpeed, Batch.Acceleration[Index]);
+			}
+
+			if (Params.bUseEnforcedMaxSpeed)
+			{
+				Velocity = GetClampedToMaxSizePrecise(Velocity, Params.EnforcedMaxSpeed);
+			}
+
+			Batch.VelocityX[Index] = Velocity.X;
+			Batch.VelocityY[Index] = Velocity.Y;
+			Batch.VelocityZ[Index] = Velocity.Z;
+		}
+
+#if BG_MOVEMENT_BATCH_SSE
+		// 4-wide SSE2 lanes.
+		struct FSSELanes
+		{
+			typedef __m128 FReg;
+			static const size_t Width = 4;
+
+			static FReg Load(const float* Src) { return _mm_loadu_ps(Src); }
+			static void Store(float* Dst, FReg V) { _mm_storeu_ps(Dst, V); }
+			static FReg Set(float V) { return _mm_set1_ps(V); }
+			static FReg Zero() { return _mm_setzero_ps(); }
+			static FReg Add(FReg A, FReg B) { return _mm_add_ps(A, B); }
+			static FReg Sub(FReg A, FReg B) { return _mm_sub_ps(A, B); }
+			static FReg Mul(FReg A, FReg B) { return _mm_mul_ps(A, B); }
+			static FReg Div(FReg A, FReg B) { return _mm_div_ps(A, B); }
+			static FReg Min(FReg A, FReg B) { return _mm_min_ps(B, A); }
+			static FReg Max(FReg A, FReg B) { return _mm_max_ps(B, A); }
+			static FReg Sqrt(FReg V) { return _mm_sqrt_ps(V); }
+			static FReg Less(FReg A, FReg B) { return _mm_cmplt_ps(A, B); }
+			static FReg Greater(FReg A, FReg B) { return _mm_cmpgt_ps(A, B); }
+			static FReg And(FReg A, FReg B) { return _mm_and_ps(A, B); }
+			static FReg AndNot(FReg Mask, FReg V) { return _mm_andnot_ps(Mask, V); }
+			static FReg Or(FReg A, FReg B) { return _mm_or_ps(A, B); }
+			static FReg Select(FReg Mask, FReg IfTrue, FReg IfFalse) { return _mm_or_ps(_mm_and_ps(Mask, IfTrue), _mm_andnot_ps(Mask, IfFalse)); }
+
+			static FReg LoadFlag(const uint32_t* Src, uint32_t Flag)
+			{
+				const auto FlagReg = _mm_set1_epi32(static_cast<int>(Flag));
+				const auto Flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src));
+				return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(Flags, FlagReg), FlagReg));
+			}
+		};
+#endif // BG_MOVEMENT_BATCH_SSE
+
+#if BG_MOVEMENT_BATCH_AVX2
+		// 8-wide AVX2 lanes.
+		struct FAVX2Lanes
+		{
+			typedef __m256 FReg;
+			static const size_t Width = 8;
+
+			static FReg Load(const float* Src) { return _mm256_loadu_ps(Src); }
+			static void Store(float* Dst, FReg V) { _mm256_storeu_ps(Dst, V); }
+			static FReg Set(float V) { return _mm256_set1_ps(V); }
+			static FReg Zero() { return _mm256_setzero_ps(); }
+			static FReg Add(FReg A, FReg B) { return _mm256_add_ps(A, B); }
+			static FReg Sub(FReg A, FReg B) { return _mm256_sub_ps(A, B); }
+			static FReg Mul(FReg A, FReg B) { return _mm256_mul_ps(A, B); }
+			static FReg Div(FReg A, FReg B) { return _mm256_div_ps(A, B); }
+			static FReg Min(FReg A, FReg B) { return _mm256_min_ps(B, A); }
+			static FReg Max(FReg A, FReg B) { return _mm256_max_ps(B, A); }
+			static FReg Sqrt(FReg V) { return _mm256_sqrt_ps(V); }
+			static FReg Less(FReg A, FReg B) { return _mm256_cmp_ps(A, B, _CMP_LT_OQ); }
+			static FReg Greater(FReg A, FReg B) { return _mm256_cmp_ps(A, B, _CMP_GT_OQ); }
+			static FReg And(FReg A, FReg B) { return _mm256_and_ps(A, B); }
+			static FReg AndNot(FReg Mask, FReg V) { return _mm256_andnot_ps(Mask, V); }
+			static FReg Or(FReg A, FReg B) { return _mm256_or_ps(A, B); }
+			static FReg Select(FReg Mask, FReg IfTrue, FReg IfFalse) { return _mm256_blendv_ps(IfFalse, IfTrue, Mask); }
+
+			static FReg LoadFlag(const uint32_t* Src, uint32_t Flag)
+			{
+				const auto FlagReg = _mm256_set1_epi32(static_cast<int>(Flag));
+				const auto Flags = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Src));
+				return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(Flags, FlagReg), FlagReg));
+			}
+		};
+#endif // BG_MOVEMENT_BATCH_AVX2
+
+		// Solves characters [0, Num - Num % Width) of the batch, Lanes::Width at a time. Returns the number of characters solved.
+		// Mirrors SolveScalar() operation for operation - Min()/Max() take their operands in the same order as std::min()/std::max().
+		template <typename Lanes>
+		inline size_t SolveSimd(FMovementBatch& Batch, const FMovementBatchParams& Params)
+		{
+			const auto Num = Batch.Num() - (Batch.Num() % Lanes::Width);
+
+			const auto DeltaTime = Lanes::Set(Params.DeltaTime);
+			const auto StopSpeed = Lanes::Set(Params.StopSpeed);
+			const auto MaxFallAirSpeed = Lanes::Set(Params.MaxFallAirSpeed);
+			const auto MinFrictionSpeedReg = Lanes::Set(MinFrictionSpeed);
+			const auto Zero = Lanes::Zero();
+
+			const auto bClampToZero = Params.bUseEnforcedMaxSpeed && Params.EnforcedMaxSpeed < KindaSmallNumber;
+			const auto bClamp = Params.bUseEnforcedMaxSpeed && !bClampToZero;
+			const auto EnforcedMaxSpeed = Lanes::Set(Params.EnforcedMaxSpeed);
+			const auto EnforcedMaxSpeedSq = Lanes::Set(Params.EnforcedMaxSpeed * Params.EnforcedMaxSpeed);
+
+			for (size_t Index = 0; Index < Num; Index += Lanes::Width)
+			{
+				auto VX = Lanes::Load(&Batch.VelocityX[Index]);
+				auto VY = Lanes::Load(&Batch.VelocityY[Index]);
+				auto VZ = Lanes::Load(&Batch.VelocityZ[Index]);
+
+				// Ground friction.
+				const auto FrictionMask = Lanes::LoadFlag(&Batch.Flags[Index], MovementBatchFlag_ApplyFriction);
+				{
+					const auto Speed = Lanes::Sqrt(Lanes::Add(Lanes::Add(Lanes::Mul(VX, VX), Lanes::Mul(VY, VY)), Lanes::Mul(VZ, VZ)));
+					const auto ControlSpeed = Lanes::Max(StopSpeed, Speed);
+					const auto SpeedDrop = Lanes::Mul(Lanes::Mul(ControlSpeed, Lanes::Load(&Batch.Friction[Index])), DeltaTime);
+					auto Scale = Lanes::Div(Lanes::Max(Zero, Lanes::Sub(Speed, SpeedDrop)), Speed);
+
+					// Too slow to care about - stop the character.
+					Scale = Lanes::AndNot(Lanes::Less(Speed, MinFrictionSpeedReg), Scale);
+
+					VX = Lanes::Select(FrictionMask, Lanes::Mul(VX, Scale), VX);
+					VY = Lanes::Select(FrictionMask, Lanes::Mul(VY, Scale), VY);
+					VZ = Lanes::Select(FrictionMask, Lanes::Mul(VZ, Scale), VZ);
+				}
+
+				// Ground & air acceleration.
+				const auto WalkingMask = Lanes::LoadFlag(&Batch.Flags[Index], MovementBatchFlag_Walking);
+				const auto FallingMask = Lanes::AndNot(WalkingMask, Lanes::LoadFlag(&Batch.Flags[Index], MovementBatchFlag_Falling));
+				{
+					const auto WX = Lanes::Load(&Batch.WishDirectionX[Index]);
+					const auto WY = Lanes::Load(&Batch.WishDirectionY[Index]);
+					const auto WZ = Lanes::Load(&Batch.WishDirectionZ[Index]);
+					const auto WishSpeed = Lanes::Load(&Batch.WishSpeed[Index]);
+
+					// Air acceleration caps the projected wish speed only.
+					const auto CappedWishSpeed = Lanes::Select(FallingMask, Lanes::Min(WishSpeed, MaxFallAirSpeed), WishSpeed);
+
+					const auto VeloProj = Lanes::Add(Lanes::Add(Lanes::Mul(VX, WX), Lanes::Mul(VY, WY)), Lanes::Mul(VZ, WZ));
+					const auto AddSpeed = Lanes::Sub(CappedWishSpeed, VeloProj);
+					const auto AccelSpeed = Lanes::Min(Lanes::Mul(Lanes::Mul(Lanes::Load(&Batch.Acceleration[Index]), WishSpeed), DeltaTime), AddSpeed);
+
+					const auto AccelMask = Lanes::And(Lanes::Or(WalkingMask, FallingMask), Lanes::Greater(AddSpeed, Zero));
+					VX = Lanes::Select(AccelMask, Lanes::Add(VX, Lanes::Mul(AccelSpeed, WX)), VX);
+					VY = Lanes::Select(AccelMask, Lanes::Add(VY, Lanes::Mul(AccelSpeed, WY)), VY);
+					VZ = Lanes::Select(AccelMask, Lanes::Add(VZ, Lanes::Mul(AccelSpeed, WZ)), VZ);
+				}
+
+				// Enforced max speed.
+				if (bClampToZero)
+				{
+					VX = VY = VZ = Zero;
+				}
+				else if (bClamp)
+				{
+					const auto SpeedSq = Lanes::Add(Lanes::Add(Lanes::Mul(VX, VX), Lanes::Mul(VY, VY)), Lanes::Mul(VZ, VZ));
+					const auto ClampMask = Lanes::Greater(SpeedSq, EnforcedMaxSpeedSq);
+					const auto Scale = Lanes::Div(EnforcedMaxSpeed, Lanes::Sqrt(SpeedSq));
+
+					VX = Lanes::Select(ClampMask, Lanes::Mul(VX, Scale), VX);
+					VY = Lanes::Select(ClampMask, Lanes::Mul(VY, Scale), VY);
+					VZ = Lanes::Select(ClampMask, Lanes::Mul(VZ, Scale), VZ);
+				}
+
+				Lanes::Store(&Batch.VelocityX[Index], VX);
+				Lanes::Store(&Batch.VelocityY[Index], VY);
+				Lanes::Store(&Batch.VelocityZ[Index], VZ);
+			}
+
+			return Num;
+		}
+	}
+
+	// Solves the batch one character at a time with the scalar math. This is the reference for the SIMD path.
+	inline void SolveMovementBatchScalar(FMovementBatch& Batch, const FMovementBatchParams& Params)
+	{
+		for (size_t Index = 0; Index < Batch.Num(); ++Index)
+		{
+			MovementBatchDetail::SolveScalar(Batch, Params, Index);
+		}
+	}
+
+	// Solves the batch with the widest SIMD kernel available in this build (the remainder is solved with the scalar math).
+	inline void SolveMovementBatch(FMovementBatch& Batch, const FMovementBatchParams& Params)
+	{
+		size_t NumSolved = 0;
+
+#if BG_MOVEMENT_BATCH_AVX2
+		NumSolved = MovementBatchDetail::SolveSimd<MovementBatchDetail::FAVX2Lanes>(Batch, Params);
+#elif BG_MOVEMENT_BATCH_SSE
+		NumSolved = MovementBatchDetail::SolveSimd<MovementBatchDetail::FSSELanes>(Batch, Params);
+#endif
+
+		for (auto Index = NumSolved; Index < Batch.Num(); ++Index)
+		{
+			MovementBatchDetail::SolveScalar(Batch, Params, Index);
+		}
+	}
+
+	// Name of the kernel used by SolveMovementBatch() in this build.
+	inline const char* GetMovementBatchKernelName()
+	{
+#if BG_MOVEMENT_BATCH_AVX2
+		return "AVX2";
+#elif BG_MOVEMENT_BATCH_SSE
+		return "SSE2";
+#else
+		return "scalar";
+#endif
+	}
+}
@@ -0,0 +1,376 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define BG_FAST_MATH_SSE 1
+#else
+#define BG_FAST_MATH_SSE 0
+#endif
+
+/**
+ * Engine-free movement math used by USD5BunnyGunCharacterMovement.
+ *
+ * Nothing in here depends on UObject or the rest of the engine so that the hot-path math can be built and
+ * profiled on its own (see Benchmark/). Functions are templated on the vector type, which only needs public
+ * float X, Y & Z members and an (X, Y, Z) constructor - FVector works as-is.
+ *
+ * The functions that need sqrt, acos or pow are also templated on a math policy. By default this is
+ * FPreciseMathPolicy, which gives the same results as the engine. Define BG_ENABLE_FAST_MATH for the build to use
+ * FFastMathPolicy instead, which trades some accuracy (see the FastMath*Error constants) for speed.
+ */
+namespace SD5BunnyGunMovementMath
+{
+	// Same values as the engine's SMALL_NUMBER, KINDA_SMALL_NUMBER & PI.
+	const float SmallNumber = 1.e-8f;
+	const float KindaSmallNumber = 1.e-4f;
+	const float Pi = 3.1415926535897932f;
+
+	// Speed (in cm/s) below which friction just stops the character.
+	const float MinFrictionSpeed = 10.0f;
+
+	// How far (sine of the angle) the velocity has to be past the target direction before strafing switches sides.
+	const float AirStrafeSideDeadZone = 0.087f;
+
+	// Tuning values used by ApplyTrimpingVelocity().
+	struct FTrimpingParams
+	{
+		float JumpZVelocity;
+		float MaxTrimpJumpHeightReductionMultiplier;
+		float MaxTrimpVerticalVelocityBoost;
+		float TrimpVerticalVelocityBoostMultiplier;
+		float MaxTrimpHorizSpeedBoost;
+		float TrimpHorizSpeedBoostMultiplier;
+	};
+
+	// Tuning values used by the CS-like stamina system.
+	struct FStaminaParams
+	{
+		float MaxStamina;
+		float StaminaJumpCost;
+		float StaminaRecoveryRate;
+	};
+
+	// Maximum errors of FFastMathPolicy against FPreciseMathPolicy, checked by Benchmark/SD5BunnyGunFastMathBenchmark.cpp.
+	const float FastMathInvSqrtRelativeError = 1.e-6f;
+	const float FastMathAcosError = 1.e-4f;
+
+	// Uses the standard library, like FMath does.
+	struct FPreciseMathPolicy
+	{
+		static const char* GetName() { return "precise"; }
+
+		static float Sqrt(float Value) { return std::sqrt(Value); }
+		static float InvSqrt(float Value) { return 1.0f / std::sqrt(Value); }
+
+		// Input is clamped to [-1, 1], like FMath::Acos().
+		static float Acos(float Value) { return std::acos(std::max(-1.0f, std::min(1.0f, Value))); }
+
+		static float Pow(float Base, float Exponent) { return std::pow(Base, Exponent); }
+	};
+
+	// Approximations. Only meant for positive, finite input (Acos clamps its input like the precise version).
+	struct FFastMathPolicy
+	{
+		static const char* GetName() { return "fast"; }
+
+		// Hardware estimate refined with Newton-Raphson, like FMath::InvSqrt().
+		// NOTE: Without SSE there's no estimate instruction, so it's the same as precise.
+		static float InvSqrt(float Value)
+		{
+#if BG_FAST_MATH_SSE
+			auto Result = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(Value)));
+			Result *= 1.5f - 0.5f * Value * Result * Result;
+
+			return Result;
+#else
+			return 1.0f / std::sqrt(Value);
+#endif // BG_FAST_MATH_SSE
+		}
+
+		// NOTE: sqrtss is already a single instruction - approximating it measured slower, so it's the same as precise.
+		static float Sqrt(float Value) { return std::sqrt(Value); }
+
+		// Abramowitz & Stegun 4.4.45, mirrored for negative input.
+		static float Acos(float Value)
+		{
+			const auto X = std::min(1.0f, std::abs(Value));
+			const auto Result = Sqrt(1.0f - X) * (1.5707288f + X * (-0.2121144f + X * (0.0742610f + X * -0.0187293f)));
+
+			return (Value < 0.0f ? Pi - Result : Result);
+		}
+
+		// NOTE: Every polynomial exp2(log2()) approximation tried measured slower than powf, so it's the same as precise.
+		static float Pow(float Base, float Exponent) { return std::pow(Base, Exponent); }
+	};
+
+#ifdef BG_ENABLE_FAST_MATH
+	typedef FFastMathPolicy FMovementMathPolicy;
+#else
+	typedef FPreciseMathPolicy FMovementMathPolicy;
+#endif // BG_ENABLE_FAST_MATH
+
+	template <typename VectorType>
+	inline float DotProduct(const VectorType& A, const VectorType& B)
+	{
+		return A.X * B.X + A.Y * B.Y + A.Z * B.Z;
+	}
+
+	template <typename VectorType>
+	inline float SizeSquared(const VectorType& V)
+	{
+		return V.X * V.X + V.Y * V.Y + V.Z * V.Z;
+	}
+
+	// !!! Copied from CharacterMovementComponent.cpp !!!
+	// * * * * *
+
+	// NOTE: these always use the precise math, regardless of the math policy.
+
+	// Version that does not use inverse sqrt estimate, for higher precision.
+	template <typename VectorType>
+	inline VectorType GetSafeNormalPrecise(const VectorType& V)
+	{
+		const auto VSq = SizeSquared(V);
+		if (VSq < SmallNumber)
+		{
+			return VectorType(0.0f, 0.0f, 0.0f);
+		}
+		else
+		{
+			const auto Scale = 1.f / std::sqrt(VSq);
+			return VectorType(V.X * Scale, V.Y * Scale, V.Z * Scale);
+		}
+	}
+
+	// Version that does not use inverse sqrt estimate, for higher precision.
+	template <typename VectorType>
+	inline VectorType GetClampedToMaxSizePrecise(const VectorType& V, float MaxSize)
+	{
+		if (MaxSize < KindaSmallNumber)
+		{
+			return VectorType(0.0f, 0.0f, 0.0f);
+		}
+
+		const auto VSq = SizeSquared(V);
+		if (VSq > MaxSize * MaxSize)
+		{
+			const auto Scale = MaxSize / std::sqrt(VSq);
+			return VectorType(V.X * Scale, V.Y * Scale, V.Z * Scale);
+		}
+		else
+		{
+			return V;
+		}
+	}
+
+	// * * * * *
+
+	// Calc and apply acceleration from movement input.
+	template <typename VectorType>
+	inline void ApplyAcceleration(VectorType& Velocity, float DeltaTime, float SurfaceFriction, const VectorType& WishDirection, float WishSpeed, float Acceleration)
+	{
+		const auto VeloProj = DotProduct(Velocity, WishDirection);
+		const auto AddSpeed = WishSpeed - VeloProj;
+		if (AddSpeed <= 0.0f)
+		{
+			return;
+		}
+
+		auto AccelSpeed = Acceleration * WishSpeed * SurfaceFriction * DeltaTime;
+		AccelSpeed = std::min(AccelSpeed, AddSpeed);
+
+		Velocity.X += AccelSpeed * WishDirection.X;
+		Velocity.Y += AccelSpeed * WishDirection.Y;
+		Velocity.Z += AccelSpeed * WishDirection.Z;
+	}
+
+	// Calc and apply air acceleration from movement input. Wish speed is capped to MaxAirWishSpeed for the projection only,
+	// which is what makes air-strafing gain speed.
+	template <typename VectorType>
+	inline void ApplyAirAcceleration(VectorType& Velocity, float DeltaTime, float SurfaceFriction, const VectorType& WishDirection, float WishSpeed, float MaxAirWishSpeed, float Acceleration)
+	{
+		const auto AirWishSpeed = std::min(WishSpeed, MaxAirWishSpeed);
+
+		const auto VeloProj = DotProduct(Velocity, WishDirection);
+		const auto AddSpeed = AirWishSpeed - VeloProj;
+		if (AddSpeed <= 0.0f)
+		{
+			return;
+		}
+
+		auto AccelSpeed = Acceleration * WishSpeed * SurfaceFriction * DeltaTime;
+		AccelSpeed = std::min(AccelSpeed, AddSpeed);
+
+		Velocity.X += AccelSpeed * WishDirection.X;
+		Velocity.Y += AccelSpeed * WishDirection.Y;
+		Velocity.Z += AccelSpeed * WishDirection.Z;
+	}
+
+	// Returns the cosine of the angle between the horizontal velocity & the wish direction that gains the most speed from
+	// ApplyAirAcceleration() in a tick. AccelSpeed is only added in full while the projection of the velocity leaves room for
+	// it under the air wish speed, so the best angle leaves exactly that much room. Once AccelSpeed is over the air wish speed,
+	// the best angle is perpendicular instead (speed^2 gains AirWishSpeed^2, more than 2 * AccelSpeed * AirWishSpeed - AccelSpeed^2).
+	inline float GetOptimalAirStrafeCos(float Speed, float AirWishSpeed, float AccelSpeed)
+	{
+		if (Speed <= SmallNumber)
+		{
+			return 1.0f;
+		}
+
+		return std::min(1.0f, std::max(0.0f, (AirWishSpeed - AccelSpeed) / Speed));
+	}
+
+	// Returns the horizontal wish direction that gains the most speed from ApplyAirAcceleration() this tick, strafing to
+	// the side of TargetDirection (horizontal & normalized) so that the velocity turns towards it. InOutSide (1 or -1) is
+	// the side strafed to last, which is kept until the velocity is AirStrafeSideDeadZone past the target direction.
+	// Too slow to need strafing, this is just TargetDirection.
+	template <typename MathPolicy = FMovementMathPolicy, typename VectorType>
+	inline VectorType GetOptimalAirStrafeDirection(const VectorType& Velocity, const VectorType& TargetDirection, float DeltaTime, float SurfaceFriction,
+		float WishSpeed, float MaxAirWishSpeed, float Acceleration, float& InOutSide)
+	{
+		const auto SpeedSquared = Velocity.X * Velocity.X + Velocity.Y * Velocity.Y;
+		const auto Speed = MathPolicy::Sqrt(SpeedSquared);
+		const auto AirWishSpeed = std::min(WishSpeed, MaxAirWishSpeed);
+		const auto AccelSpeed = Acceleration * WishSpeed * SurfaceFriction * DeltaTime;
+
+		const auto Cos = GetOptimalAirStrafeCos(Speed, AirWishSpeed, AccelSpeed);
+		if (Cos >= 1.0f)
+		{
+			return TargetDirection;
+		}
+
+		const auto DirectionX = Velocity.X / Speed;
+		const auto DirectionY = Velocity.Y / Speed;
+
+		// Sine of the angle from the velocity to the target, positive if the target is to the left.
+		const auto TargetSin = DirectionX * TargetDirection.Y - DirectionY * TargetDirection.X;
+		if (std::abs(TargetSin) > AirStrafeSideDeadZone || DirectionX * TargetDirection.X + DirectionY * TargetDirection.Y < 0.0f)
+		{
+			InOutSide = (TargetSin >= 0.0f ? 1.0f : -1.0f);
+		}
+
+		// Rotate the velocity direction by the optimal angle towards the side.
+		const auto Sin = InOutSide * MathPolicy::Sqrt(std::max(0.0f, 1.0f - Cos * Cos));
+		return VectorType(Cos * DirectionX - Sin * DirectionY, Sin * DirectionX + Cos * DirectionY, 0.0f);
+	}
+
+	// Returns whether or not a bot should move on from a path point: it is within AcceptanceRadius (2D), or it has been passed
+	// (the velocity leads away from it & it is within the distance covered in OvershootTime). A fast air-strafer can't turn
+	// tightly enough to get within the acceptance radius of a point it overshot, so it would otherwise circle it.
+	template <typename VectorType>
+	inline bool ShouldAdvancePathPoint(const VectorType& Location, const VectorType& Velocity, const VectorType& PathPoint, float AcceptanceRadius, float OvershootTime)
+	{
+		const auto ToPointX = PathPoint.X - Location.X;
+		const auto ToPointY = PathPoint.Y - Location.Y;
+		const auto DistanceSquared = ToPointX * ToPointX + ToPointY * ToPointY;
+		if (DistanceSquared < AcceptanceRadius * AcceptanceRadius)
+		{
+			return true;
+		}
+
+		const auto OvershootDistanceSquared = (Velocity.X * Velocity.X + Velocity.Y * Velocity.Y) * OvershootTime * OvershootTime;
+		return (Velocity.X * ToPointX + Velocity.Y * ToPointY < 0.0f && DistanceSquared < OvershootDistanceSquared);
+	}
+
+	// Calc and apply friction for this frame.
+	template <typename MathPolicy = FMovementMathPolicy, typename VectorType>
+	inline void ApplyFriction(VectorType& Velocity, float DeltaTime, float CharacterFriction, float SurfaceFriction, float StopSpeed)
+	{
+		const auto Speed = MathPolicy::Sqrt(SizeSquared(Velocity));
+		// Check if the speed is too small to care about...
+		if (Speed < MinFrictionSpeed)
+		{
+			Velocity = VectorType(0.0f, 0.0f, 0.0f);
+			return;
+		}
+
+		const auto ControlSpeed = std::max(StopSpeed, Speed);
+		const auto SpeedDrop = ControlSpeed * CharacterFriction * SurfaceFriction * DeltaTime;
+
+		const auto Scale = std::max(0.0f, Speed - SpeedDrop) / Speed;
+		Velocity.X *= Scale;
+		Velocity.Y *= Scale;
+		Velocity.Z *= Scale;
+	}
+
+	// Applies trimping velocity for a jump off a floor with the given normal.
+	template <typename MathPolicy = FMovementMathPolicy, typename VectorType>
+	inline void ApplyTrimpingVelocity(VectorType& Velocity, const VectorType& FloorNormal, const FTrimpingParams& Params)
+	{
+		const auto HorizVelocity = VectorType(Velocity.X, Velocity.Y, 0.0f);
+		const auto HorizSpeedSq = SizeSquared(HorizVelocity);
+		const auto HorizSpeed = MathPolicy::Sqrt(HorizSpeedSq);
+
+		// Check that we actually have some speed in horiz direction.
+		if (HorizSpeed <= SmallNumber)
+		{
+			return;
+		}
+
+		// Same as GetSafeNormalPrecise(), but with the math policy.
+		const auto HorizScale = (HorizSpeedSq < SmallNumber ? 0.0f : MathPolicy::InvSqrt(HorizSpeedSq));
+		const auto HorizVeloDirection = VectorType(HorizVelocity.X * HorizScale, HorizVelocity.Y * HorizScale, 0.0f);
+
+		// Get the angle between the normal of the slope and the horizontal direction of our velocity.
+		// If slope is inclined upwards from our horiz velo direction, angle will be > pi/2
+		// If perpendicular, angle = pi/2 aka 90 deg (dot product = 0)
+		// If slope is inclined downwards from our horiz velo direction, angle will be < pi/2
+		// Range of acos is between 0 & pi.
+		const auto Angle = MathPolicy::Acos(DotProduct(FloorNormal, HorizVeloDirection));
+
+		// If slope is inclined upwards from us. Give a height boost!
+		// If the slope is inclined downwards, we'll lose some speed instead.
+		const auto VerticalBoostSlopeMultiplier = ((2.0f * Angle) / Pi) - 1.0f;
+		auto VerticalVelocityBoost = std::min(HorizSpeed * VerticalBoostSlopeMultiplier * Params.TrimpVerticalVelocityBoostMultiplier, Params.MaxTrimpVerticalVelocityBoost);
+		VerticalVelocityBoost = std::max(Params.JumpZVelocity * -Params.MaxTrimpJumpHeightReductionMultiplier, VerticalVelocityBoost);
+
+		Velocity.Z += VerticalVelocityBoost;
+
+		// If on a slope inclined below us, apply a horizontal speed boost too.
+		if (Angle < (Pi * 0.5f))
+		{
+			// Slope is inclined below us. Start to give a horizontal speed boost.
+			const auto HorizBoostSlopeMultiplier = 1.0f - ((2.0f * Angle) / Pi);
+			const auto HorizSpeedBoost = std::min(HorizSpeed * HorizBoostSlopeMultiplier * Params.TrimpHorizSpeedBoostMultiplier, Params.MaxTrimpHorizSpeedBoost);
+
+			Velocity.X += HorizVeloDirection.X * HorizSpeedBoost;
+			Velocity.Y += HorizVeloDirection.Y * HorizSpeedBoost;
+		}
+	}
+
+	// Mimic Counter-Strike's stamina logic: the fraction of speed kept with the given amount of stamina.
+	inline float GetStaminaSpeedFraction(float Stamina, const FStaminaParams& Params)
+	{
+		return (Params.MaxStamina - ((Stamina / 1000.0f) * Params.StaminaRecoveryRate)) / Params.MaxStamina;
+	}
+
+	// Multiplier applied to the vertical velocity of a jump.
+	inline float GetStaminaJumpVelocityMultiplier(float Stamina, const FStaminaParams& Params)
+	{
+		return (Stamina > 0.0f ? GetStaminaSpeedFraction(Stamina, Params) : 1.0f);
+	}
+
+	// Multiplier applied to the horizontal velocity while walking this frame.
+	template <typename MathPolicy = FMovementMathPolicy>
+	inline float GetStaminaWalkSpeedMultiplier(float Stamina, float DeltaTime, const FStaminaParams& Params)
+	{
+		return (Stamina > 0.0f ? MathPolicy::Pow(GetStaminaSpeedFraction(Stamina, Params), 70.0f * DeltaTime) : 1.0f);
+	}
+
+	// The value stamina is set to after a jump.
+	inline float GetStaminaAfterJump(const FStaminaParams& Params)
+	{
+		return (Params.StaminaJumpCost * 1000.0f) / Params.StaminaRecoveryRate;
+	}
+
+	// Decreases the current amount of stamina over time.
+	inline float DecayStamina(float Stamina, float DeltaTime)
+	{
+		return (Stamina > 0.0f ? std::max(0.0f, Stamina - 1000.0f * DeltaTime) : Stamina);
+	}
+}
@@ -0,0 +1,79 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGun.h"
+#include "SD5BunnyGunMovementProfile.h"
+#include "SD5BunnyGunCharacter.h"
+#include "SD5BunnyGunCharacterMovement.h"
+
+// NOTE: Defaults are the same as the defaults of USD5BunnyGunCharacterMovement & ASD5BunnyGunCharacter.
+USD5BunnyGunMovementProfile::USD5BunnyGunMovementProfile() :
+Super(),
+bCanSlowWalk(true),
+SlowWalkingMaxSpeedMultiplier(0.3f),
+StopSpeed(150.0f),
+NoFrictionAfterLandingTime(0.0f),
+bUseEnforcedMaxSpeed(true),
+EnforcedMaxSpeed(3500.0f),
+MaxFallAirSpeed(100.0f),
+MaxAirAcceleration(20.0f),
+bEnableTrimping(true),
+MaxTrimpJumpHeightReductionMultiplier(0.375f),
+MaxTrimpVerticalVelocityBoost(2000.0f),
+TrimpVerticalVelocityBoostMultiplier(1.25f),
+MaxTrimpHorizSpeedBoost(1000.0f),
+TrimpHorizSpeedBoostMultiplier(2.75f),
+#ifdef BG_ENABLE_STAMINA
+bEnableStamina(false),
+MaxStamina(100.0f),
+StaminaJumpCost(25.0f),
+StaminaRecoveryRate(20.0f),
+#endif // BG_ENABLE_STAMINA
+bEnableFallDamage(true),
+FallDamageMinZVelocity(700.0f),
+FallDamageZVelocityMultiplier(0.6f),
+bUseAccelerationForFallDamageCameraTilt(true),
+FallDamageCameraTiltMultiplier(0.125f),
+MaxFallDamageCameraTilt(20.0f),
+FallDamageCameraTiltDecayMultiplier(25.0f)
+{ }
+
+void USD5BunnyGunMovementProfile::ApplyTo(ASD5BunnyGunCharacter* Character) const
+{
+	Character->bEnableFallDamage = bEnableFallDamage;
+	Character->FallDamageMinZVelocity = FallDamageMinZVelocity;
+	Character->FallDamageZVelocityMultiplier = FallDamageZVelocityMultiplier;
+	Character->bUseAccelerationForFallDamageCameraTilt = bUseAccelerationForFallDamageCameraTilt;
+	Character->FallDamageCameraTiltMultiplier = FallDamageCameraTiltMultiplier;
+	Character->MaxFallDamageCameraTilt = MaxFallDamageCameraTilt;
+	Character->FallDamageCameraTiltDecayMultiplier = FallDamageCameraTiltDecayMultiplier;
+
+	const auto Movement = Cast<USD5BunnyGunCharacterMovement>(Character->GetCharacterMovement());
+	if (Movement == nullptr)
+	{
+		return;
+	}
+
+	Movement->bCanSlowWalk = bCanSlowWalk;
+	Movement->SlowWalkingMaxSpeedMultiplier = SlowWalkingMaxSpeedMultiplier;
+	Movement->StopSpeed = StopSpeed;
+	Movement->NoFrictionAfterLandingTime = NoFrictionAfterLandingTime;
+	Movement->bUseEnforcedMaxSpeed = bUseEnforcedMaxSpeed;
+	Movement->EnforcedMaxSpeed = EnforcedMaxSpeed;
+	Movement->MaxFallAirSpeed = MaxFallAirSpeed;
+	Movement->MaxAirAcceleration = MaxAirAcceleration;
+	Movement->bEnableTrimping = bEnableTrimping;
+	Movement->MaxTrimpJumpHeightReductionMultiplier = MaxTrimpJumpHeightReductionMultiplier;
+	Movement->MaxTrimpVerticalVelocityBoost = MaxTrimpVerticalVelocityBoost;
+	Movement->TrimpVerticalVelocityBoostMultiplier = TrimpVerticalVelocityBoostMultiplier;
+	Movement->MaxTrimpHorizSpeedBoost = MaxTrimpHorizSpeedBoost;
+	Movement->TrimpHorizSpeedBoostMultiplier = TrimpHorizSpeedBoostMultiplier;
+
+#ifdef BG_ENABLE_STAMINA
+	Movement->bEnableStamina = bEnableStamina;
+	Movement->MaxStamina = MaxStamina;
+	Movement->StaminaJumpCost = StaminaJumpCost;
+	Movement->StaminaRecoveryRate = StaminaRecoveryRate;
+#endif // BG_ENABLE_STAMINA
+
+	Movement->UpdateMovementVariant();
+}
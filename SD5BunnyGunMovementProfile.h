@@ -0,0 +1,105 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+#include "Engine/DataAsset.h"
+#include "SD5BunnyGunMovementProfile.generated.h"
+
+class ASD5BunnyGunCharacter;
+
+/**
+ * Movement & fall damage tuning shared by Bunny Gun characters.
+ *
+ * Characters reference a profile through ASD5BunnyGunCharacter::MovementProfile. Only that reference is replicated
+ * (a single object handle, sent again only when it changes), rather than every tuning value on every character,
+ * so the server doesn't compare them each net update and joining clients don't receive them per character.
+ * See USD5BunnyGunCharacterMovement & ASD5BunnyGunCharacter for what each value does.
+ */
+UCLASS(BlueprintType)
+class SD5BUNNYGUN_API USD5BunnyGunMovementProfile : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	USD5BunnyGunMovementProfile();
+
+	// Copies the values of this profile into a character and its movement component.
+	void ApplyTo(ASD5BunnyGunCharacter* Character) const;
+
+	UPROPERTY(Category = "Character Movement: Walking", EditDefaultsOnly)
+	uint32 bCanSlowWalk : 1;
+
+	UPROPERTY(Category = "Character Movement: Walking", EditDefaultsOnly, meta = (EditCondition = "bCanSlowWalk", ClampMin = "0", UIMin = "0", ClampMax = "1", UIMax = "1"))
+	float SlowWalkingMaxSpeedMultiplier;
+
+	UPROPERTY(Category = "Character Movement: Walking", EditDefaultsOnly, meta = (ClampMin = "0", UIMin = "0"))
+	float StopSpeed;
+
+	UPROPERTY(Category = "Character Movement: Bunnyhopping", EditDefaultsOnly, meta = (ClampMin = "0", UIMin = "0"))
+	float NoFrictionAfterLandingTime;
+
+	UPROPERTY(Category = "Character Movement: Bunnyhopping", EditDefaultsOnly)
+	uint32 bUseEnforcedMaxSpeed : 1;
+
+	UPROPERTY(Category = "Character Movement: Bunnyhopping", EditDefaultsOnly, meta = (EditCondition = "bUseEnforcedMaxSpeed", ClampMin = "0", UIMin = "0"))
+	float EnforcedMaxSpeed;
+
+	UPROPERTY(Category = "Character Movement: Jumping / Falling", EditDefaultsOnly, meta = (ClampMin = "0", UIMin = "0"))
+	float MaxFallAirSpeed;
+
+	UPROPERTY(Category = "Character Movement: Jumping / Falling", EditDefaultsOnly, meta = (ClampMin = "0", UIMin = "0"))
+	float MaxAirAcceleration;
+
+	UPROPERTY(Category = "Character Movement: Trimping", EditDefaultsOnly)
+	uint32 bEnableTrimping : 1;
+
+	UPROPERTY(Category = "Character Movement: Trimping", EditDefaultsOnly, meta = (EditCondition = "bEnableTrimping", ClampMin = "0", UIMin = "0"))
+	float MaxTrimpJumpHeightReductionMultiplier;
+
+	UPROPERTY(Category = "Character Movement: Trimping", EditDefaultsOnly, meta = (EditCondition = "bEnableTrimping", ClampMin = "0", UIMin = "0"))
+	float MaxTrimpVerticalVelocityBoost;
+
+	UPROPERTY(Category = "Character Movement: Trimping", EditDefaultsOnly, meta = (EditCondition = "bEnableTrimping", ClampMin = "0", UIMin = "0"))
+	float TrimpVerticalVelocityBoostMultiplier;
+
+	UPROPERTY(Category = "Character Movement: Trimping", EditDefaultsOnly, meta = (EditCondition = "bEnableTrimping", ClampMin = "0", UIMin = "0"))
+	float MaxTrimpHorizSpeedBoost;
+
+	UPROPERTY(Category = "Character Movement: Trimping", EditDefaultsOnly, meta = (EditCondition = "bEnableTrimping", ClampMin = "0", UIMin = "0"))
+	float TrimpHorizSpeedBoostMultiplier;
+
+#ifdef BG_ENABLE_STAMINA
+	UPROPERTY(Category = "Character Movement: Stamina", EditDefaultsOnly)
+	uint32 bEnableStamina : 1;
+
+	UPROPERTY(Category = "Character Movement: Stamina", EditDefaultsOnly, meta = (EditCondition = "bEnableStamina", ClampMin = "0", UIMin = "0"))
+	float MaxStamina;
+
+	UPROPERTY(Category = "Character Movement: Stamina", EditDefaultsOnly, meta = (EditCondition = "bEnableStamina", ClampMin = "0", UIMin = "0"))
+	float StaminaJumpCost;
+
+	UPROPERTY(Category = "Character Movement: Stamina", EditDefaultsOnly, meta = (EditCondition = "bEnableStamina", ClampMin = "0", UIMin = "0"))
+	float StaminaRecoveryRate;
+#endif // BG_ENABLE_STAMINA
+
+	UPROPERTY(Category = "Character: Fall Damage", EditDefaultsOnly)
+	uint32 bEnableFallDamage : 1;
+
+	UPROPERTY(Category = "Character: Fall Damage", EditDefaultsOnly, meta = (EditCondition = "bEnableFallDamage", ClampMin = "0", UIMin = "0"))
+	float FallDamageMinZVelocity;
+
+	UPROPERTY(Category = "Character: Fall Damage", EditDefaultsOnly, meta = (EditCondition = "bEnableFallDamage", ClampMin = "0", UIMin = "0"))
+	float FallDamageZVelocityMultiplier;
+
+	UPROPERTY(Category = "Character: Fall Damage", EditDefaultsOnly, meta = (EditCondition = "bEnableFallDamage"))
+	uint32 bUseAccelerationForFallDamageCameraTilt : 1;
+
+	UPROPERTY(Category = "Character: Fall Damage", EditDefaultsOnly, meta = (EditCondition = "bEnableFallDamage", ClampMin = "0", UIMin = "0"))
+	float FallDamageCameraTiltMultiplier;
+
+	UPROPERTY(Category = "Character: Fall Damage", EditDefaultsOnly, meta = (EditCondition = "bEnableFallDamage", ClampMin = "0", UIMin = "0"))
+	float MaxFallDamageCameraTilt;
+
+	UPROPERTY(Category = "Character: Fall Damage", EditDefaultsOnly, meta = (EditCondition = "bEnableFallDamage", ClampMin = "0", UIMin = "0"))
+	float FallDamageCameraTiltDecayMultiplier;
+};
@@ -0,0 +1,167 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGun.h"
+#include "SD5BunnyGunMovementTelemetry.h"
+#include "SD5BunnyGunStats.h"
+
+// Log category for the movement telemetry.
+DEFINE_LOG_CATEGORY_STATIC(LogSD5BunnyGunMovementTelemetry, Log, All);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corrections"), STAT_BunnyGunNetCorrections, STATGROUP_BunnyGunNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corrections: Trimping"), STAT_BunnyGunNetCorrectionsTrimping, STATGROUP_BunnyGunNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corrections: No Friction After Landing"), STAT_BunnyGunNetCorrectionsNoFriction, STATGROUP_BunnyGunNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corrections: Autohop"), STAT_BunnyGunNetCorrectionsAutoHop, STATGROUP_BunnyGunNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corrections: Stamina"), STAT_BunnyGunNetCorrectionsStamina, STATGROUP_BunnyGunNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replays"), STAT_BunnyGunNetReplays, STATGROUP_BunnyGunNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replayed Moves"), STAT_BunnyGunNetReplayedMoves, STATGROUP_BunnyGunNet);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Replay Time (ms)"), STAT_BunnyGunNetReplayMs, STATGROUP_BunnyGunNet);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Replay Time: Trimping (ms)"), STAT_BunnyGunNetReplayMsTrimping, STATGROUP_BunnyGunNet);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Replay Time: No Friction After Landing (ms)"), STAT_BunnyGunNetReplayMsNoFriction, STATGROUP_BunnyGunNet);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Replay Time: Autohop (ms)"), STAT_BunnyGunNetReplayMsAutoHop, STATGROUP_BunnyGunNet);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Replay Time: Stamina (ms)"), STAT_BunnyGunNetReplayMsStamina, STATGROUP_BunnyGunNet);
+
+namespace
+{
+	// Totals for all moves, moves without features or moves with a feature.
+	struct FMovementTelemetryTotals
+	{
+		uint64 Corrections;
+		uint64 Replays;
+		uint64 ReplayedMoves;
+		double ReplaySeconds;
+
+		FMovementTelemetryTotals() : Corrections(0), Replays(0), ReplayedMoves(0), ReplaySeconds(0.0) { }
+	};
+
+	// Index 0 is all moves, 1 is moves without any feature and 2 onwards are the features.
+	FMovementTelemetryTotals Totals[ESD5BunnyGunMoveFeature::Num + 2];
+
+	// When the totals were last reset.
+	double StartSeconds = FPlatformTime::Seconds();
+
+	// Calls Function with the totals that a move using Features counts towards.
+	template <typename FunctionType>
+	void ForEachTotals(uint8 Features, FunctionType Function)
+	{
+		Function(Totals[0]);
+		if (Features == 0)
+		{
+			Function(Totals[1]);
+		}
+
+		for (auto FeatureIndex = 0; FeatureIndex < ESD5BunnyGunMoveFeature::Num; ++FeatureIndex)
+		{
+			if ((Features & (1 << FeatureIndex)) != 0)
+			{
+				Function(Totals[FeatureIndex + 2]);
+			}
+		}
+	}
+}
+
+void FSD5BunnyGunMovementTelemetry::RecordCorrection(uint8 Features)
+{
+	INC_DWORD_STAT(STAT_BunnyGunNetCorrections);
+	if ((Features & ESD5BunnyGunMoveFeature::Trimping) != 0) { INC_DWORD_STAT(STAT_BunnyGunNetCorrectionsTrimping); }
+	if ((Features & ESD5BunnyGunMoveFeature::NoFrictionAfterLanding) != 0) { INC_DWORD_STAT(STAT_BunnyGunNetCorrectionsNoFriction); }
+	if ((Features & ESD5BunnyGunMoveFeature::AutoHop) != 0) { INC_DWORD_STAT(STAT_BunnyGunNetCorrectionsAutoHop); }
+	if ((Features & ESD5BunnyGunMoveFeature::Stamina) != 0) { INC_DWORD_STAT(STAT_BunnyGunNetCorrectionsStamina); }
+
+	ForEachTotals(Features, [](FMovementTelemetryTotals& FeatureTotals) { ++FeatureTotals.Corrections; });
+}
+
+void FSD5BunnyGunMovementTelemetry::RecordReplay(uint8 Features, int32 NumMoves, double Seconds)
+{
+	const auto Ms = static_cast<float>(Seconds * 1000.0);
+	INC_DWORD_STAT(STAT_BunnyGunNetReplays);
+	INC_DWORD_STAT_BY(STAT_BunnyGunNetReplayedMoves, NumMoves);
+	INC_FLOAT_STAT_BY(STAT_BunnyGunNetReplayMs, Ms);
+	if ((Features & ESD5BunnyGunMoveFeature::Trimping) != 0) { INC_FLOAT_STAT_BY(STAT_BunnyGunNetReplayMsTrimping, Ms); }
+	if ((Features & ESD5BunnyGunMoveFeature::NoFrictionAfterLanding) != 0) { INC_FLOAT_STAT_BY(STAT_BunnyGunNetReplayMsNoFriction, Ms); }
+	if ((Features & ESD5BunnyGunMoveFeature::AutoHop) != 0) { INC_FLOAT_STAT_BY(STAT_BunnyGunNetReplayMsAutoHop, Ms); }
+	if ((Features & ESD5BunnyGunMoveFeature::Stamina) != 0) { INC_FLOAT_STAT_BY(STAT_BunnyGunNetReplayMsStamina, Ms); }
+
+	ForEachTotals(Features, [NumMoves, Seconds](FMovementTelemetryTotals& FeatureTotals)
+	{
+		++FeatureTotals.Replays;
+		FeatureTotals.ReplayedMoves += NumMoves;
+		FeatureTotals.ReplaySeconds += Seconds;
+	});
+}
+
+void FSD5BunnyGunMovementTelemetry::Reset()
+{
+	for (auto& FeatureTotals : Totals)
+	{
+		FeatureTotals = FMovementTelemetryTotals();
+	}
+
+	StartSeconds = FPlatformTime::Seconds();
+}
+
+const TCHAR* FSD5BunnyGunMovementTelemetry::GetFeatureName(int32 FeatureIndex)
+{
+	static const TCHAR* const FeatureNames[ESD5BunnyGunMoveFeature::Num] =
+	{
+		TEXT("Trimping"),
+		TEXT("NoFrictionAfterLanding"),
+		TEXT("AutoHop"),
+		TEXT("Stamina")
+	};
+
+	return FeatureNames[FeatureIndex];
+}
+
+FString FSD5BunnyGunMovementTelemetry::ToCsv()
+{
+	const auto ElapsedSeconds = FMath::Max(FPlatformTime::Seconds() - StartSeconds, SMALL_NUMBER);
+
+	FString Csv = TEXT("Feature,Seconds,Corrections,CorrectionsPerSecond,Replays,ReplayedMoves,MovesPerReplay,ReplayMs,ReplayMsPerReplay\n");
+	for (auto Index = 0; Index < ARRAY_COUNT(Totals); ++Index)
+	{
+		const auto& FeatureTotals = Totals[Index];
+		const auto Name = (Index == 0 ? TEXT("All") : (Index == 1 ? TEXT("None") : GetFeatureName(Index - 2)));
+		const auto Replays = FMath::Max<uint64>(FeatureTotals.Replays, 1);
+
+		Csv += FString::Printf(TEXT("%s,%.3f,%llu,%.3f,%llu,%llu,%.3f,%.3f,%.4f\n"), Name, ElapsedSeconds,
+			FeatureTotals.Corrections, FeatureTotals.Corrections / ElapsedSeconds,
+			FeatureTotals.Replays, FeatureTotals.ReplayedMoves, static_cast<double>(FeatureTotals.ReplayedMoves) / Replays,
+			FeatureTotals.ReplaySeconds * 1000.0, (FeatureTotals.ReplaySeconds * 1000.0) / Replays);
+	}
+
+	return Csv;
+}
+
+static void HandleDumpMovementTelemetryCommand(const TArray<FString>& Args)
+{
+	const auto Csv = FSD5BunnyGunMovementTelemetry::ToCsv();
+
+	TArray<FString> Lines;
+	Csv.ParseIntoArrayLines(Lines);
+	for (const auto& Line : Lines)
+	{
+		UE_LOG(LogSD5BunnyGunMovementTelemetry, Log, TEXT("%s"), *Line);
+	}
+
+	if (Args.Num() > 0)
+	{
+		const auto Path = (FPaths::IsRelative(Args[0]) ? FPaths::Combine(*FPaths::GameSavedDir(), *Args[0]) : Args[0]);
+		if (!FFileHelper::SaveStringToFile(Csv, *Path))
+		{
+			UE_LOG(LogSD5BunnyGunMovementTelemetry, Warning, TEXT("BunnyGun.DumpMovementTelemetry: could not write %s!"), *Path);
+			return;
+		}
+
+		UE_LOG(LogSD5BunnyGunMovementTelemetry, Log, TEXT("Saved movement telemetry to %s."), *Path);
+	}
+}
+
+static FAutoConsoleCommandWithArgs DumpMovementTelemetryCommand(
+	TEXT("BunnyGun.DumpMovementTelemetry"),
+	TEXT("Logs the correction & replay totals of each movement feature and optionally saves them as CSV. Usage: BunnyGun.DumpMovementTelemetry [CsvFile]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&HandleDumpMovementTelemetryCommand));
+
+static FAutoConsoleCommand ResetMovementTelemetryCommand(
+	TEXT("BunnyGun.ResetMovementTelemetry"),
+	TEXT("Resets the correction & replay totals of each movement feature."),
+	FConsoleCommandDelegate::CreateStatic(&FSD5BunnyGunMovementTelemetry::Reset));
@@ -0,0 +1,57 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+/**
+ * Movement features that can cause the server & client to disagree about a move.
+ * Tracked per move by USD5BunnyGunCharacterMovement as a bit mask.
+ */
+namespace ESD5BunnyGunMoveFeature
+{
+	enum Type
+	{
+		// ApplyTrimpingVelocity() changed the velocity of a jump.
+		Trimping = 1 << 0,
+
+		// Ground friction was skipped because of NoFrictionAfterLandingTime.
+		NoFrictionAfterLanding = 1 << 1,
+
+		// ASD5BunnyGunCharacter::ClearJumpInput() kept the jump pressed for autohop.
+		AutoHop = 1 << 2,
+
+		// The character had stamina to recover.
+		Stamina = 1 << 3
+	};
+
+	// Number of features (bits) above.
+	const int32 Num = 4;
+}
+
+/**
+ * Counts the corrections the server sends for Bunny Gun characters, and the moves replayed & the time spent replaying
+ * by clients after a correction. Everything is also counted for each feature that was active during the corrected or
+ * replayed moves (a move with several features counts towards each of them), to find which feature mispredicts.
+ *
+ * Shown live with "stat BunnyGunNet". Console commands:
+ *   BunnyGun.DumpMovementTelemetry [CsvFile]     Logs the totals since the last reset & optionally writes them to a CSV file
+ *                                                (relative to the Saved directory).
+ *   BunnyGun.ResetMovementTelemetry              Resets the totals.
+ */
+class SD5BUNNYGUN_API FSD5BunnyGunMovementTelemetry
+{
+public:
+	// Counts a correction sent by the server for a move that used Features.
+	static void RecordCorrection(uint8 Features);
+
+	// Counts a client replaying NumMoves moves that used Features after a correction, taking Seconds.
+	static void RecordReplay(uint8 Features, int32 NumMoves, double Seconds);
+
+	// Resets the totals.
+	static void Reset();
+
+	// Returns the totals as CSV, one row for all moves, moves without any feature & each feature.
+	static FString ToCsv();
+
+	// Returns the name of a feature bit.
+	static const TCHAR* GetFeatureName(int32 FeatureIndex);
+};
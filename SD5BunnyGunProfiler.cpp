@@ -0,0 +1,153 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGun.h"
+#include "SD5BunnyGunProfiler.h"
+
+// Log category for the profiler.
+DEFINE_LOG_CATEGORY_STATIC(LogSD5BunnyGunProfiler, Log, All);
+
+bool FSD5BunnyGunProfiler::bIsRecording = false;
+
+namespace
+{
+	// Cycles & calls of each scope in the current frame. Added to atomically, as the velocity phase may run on worker threads.
+	volatile int32 FrameScopeCycles[ESD5BunnyGunProfilerScope::Num];
+	volatile int32 FrameScopeCalls[ESD5BunnyGunProfilerScope::Num];
+
+	// The recorded frames as CSV, without the header.
+	FString RecordedCsv;
+	int32 NumRecordedFrames = 0;
+
+	FString RecordingPath;
+	double RecordingEndSeconds = 0.0;
+	FDelegateHandle EndFrameHandle;
+
+	void ResetFrameScopes()
+	{
+		for (auto ScopeIndex = 0; ScopeIndex < ESD5BunnyGunProfilerScope::Num; ++ScopeIndex)
+		{
+			FrameScopeCycles[ScopeIndex] = 0;
+			FrameScopeCalls[ScopeIndex] = 0;
+		}
+	}
+
+	// Adds a row for the frame that just ended & stops recording once the window has passed.
+	void HandleEndFrame()
+	{
+		RecordedCsv += FString::Printf(TEXT("%llu,%.4f"), static_cast<uint64>(GFrameCounter), FApp::GetDeltaTime() * 1000.0);
+		for (auto ScopeIndex = 0; ScopeIndex < ESD5BunnyGunProfilerScope::Num; ++ScopeIndex)
+		{
+			RecordedCsv += FString::Printf(TEXT(",%.4f,%d"), FPlatformTime::ToMilliseconds(FrameScopeCycles[ScopeIndex]), FrameScopeCalls[ScopeIndex]);
+		}
+		RecordedCsv += TEXT("\n");
+		++NumRecordedFrames;
+
+		ResetFrameScopes();
+
+		if (FPlatformTime::Seconds() >= RecordingEndSeconds)
+		{
+			FSD5BunnyGunProfiler::StopRecording();
+		}
+	}
+}
+
+void FSD5BunnyGunProfiler::StartRecording(float Seconds, const FString& Filename)
+{
+	if (bIsRecording)
+	{
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	}
+
+	ResetFrameScopes();
+	RecordedCsv.Empty();
+	NumRecordedFrames = 0;
+	RecordingPath = (FPaths::IsRelative(Filename) ? FPaths::Combine(*FPaths::GameSavedDir(), *Filename) : Filename);
+	RecordingEndSeconds = FPlatformTime::Seconds() + Seconds;
+
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&HandleEndFrame);
+	bIsRecording = true;
+}
+
+bool FSD5BunnyGunProfiler::StopRecording()
+{
+	if (!bIsRecording)
+	{
+		return false;
+	}
+
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	bIsRecording = false;
+
+	FString Csv = TEXT("Frame,FrameMs");
+	for (auto ScopeIndex = 0; ScopeIndex < ESD5BunnyGunProfilerScope::Num; ++ScopeIndex)
+	{
+		const auto Name = GetScopeName(static_cast<ESD5BunnyGunProfilerScope::Type>(ScopeIndex));
+		Csv += FString::Printf(TEXT(",%sMs,%sCalls"), Name, Name);
+	}
+	Csv += TEXT("\n");
+	Csv += RecordedCsv;
+	RecordedCsv.Empty();
+
+	if (!FFileHelper::SaveStringToFile(Csv, *RecordingPath))
+	{
+		UE_LOG(LogSD5BunnyGunProfiler, Warning, TEXT("BunnyGun.ProfileCsv: could not write %s!"), *RecordingPath);
+		return false;
+	}
+
+	UE_LOG(LogSD5BunnyGunProfiler, Log, TEXT("Saved %d profiled frames to %s."), NumRecordedFrames, *RecordingPath);
+	return true;
+}
+
+void FSD5BunnyGunProfiler::AddScopeCycles(ESD5BunnyGunProfilerScope::Type Scope, uint32 Cycles)
+{
+	FPlatformAtomics::InterlockedAdd(&FrameScopeCycles[Scope], static_cast<int32>(Cycles));
+	FPlatformAtomics::InterlockedIncrement(&FrameScopeCalls[Scope]);
+}
+
+const TCHAR* FSD5BunnyGunProfiler::GetScopeName(ESD5BunnyGunProfilerScope::Type Scope)
+{
+	static const TCHAR* const ScopeNames[ESD5BunnyGunProfilerScope::Num] =
+	{
+		TEXT("CharacterTick"),
+		TEXT("CalcVelocity"),
+		TEXT("ApplyFriction"),
+		TEXT("ApplyAirAcceleration"),
+		TEXT("DoJump"),
+		TEXT("ApplyTrimpingVelocity"),
+		TEXT("TakeDamage"),
+		TEXT("HandleHit"),
+		TEXT("HandleFallDamage"),
+		TEXT("OnDeath"),
+		TEXT("RagdollCharacter")
+	};
+
+	return ScopeNames[Scope];
+}
+
+static void HandleProfileCsvCommand(const TArray<FString>& Args)
+{
+	const auto Seconds = (Args.Num() > 0 ? FCString::Atof(*Args[0]) : 0.0f);
+	if (Seconds <= 0.0f)
+	{
+		UE_LOG(LogSD5BunnyGunProfiler, Warning, TEXT("Usage: BunnyGun.ProfileCsv <Seconds> [CsvFile]"));
+		return;
+	}
+
+	FSD5BunnyGunProfiler::StartRecording(Seconds, (Args.Num() > 1 ? Args[1] : TEXT("BunnyGunProfile.csv")));
+	UE_LOG(LogSD5BunnyGunProfiler, Log, TEXT("Profiling the next %.1f seconds."), Seconds);
+}
+
+static void HandleStopProfileCsvCommand()
+{
+	FSD5BunnyGunProfiler::StopRecording();
+}
+
+static FAutoConsoleCommandWithArgs ProfileCsvCommand(
+	TEXT("BunnyGun.ProfileCsv"),
+	TEXT("Records the time spent in the Bunny Gun hot paths every frame and saves it as CSV. Usage: BunnyGun.ProfileCsv <Seconds> [CsvFile]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&HandleProfileCsvCommand));
+
+static FAutoConsoleCommand StopProfileCsvCommand(
+	TEXT("BunnyGun.StopProfileCsv"),
+	TEXT("Stops BunnyGun.ProfileCsv early and saves the frames recorded so far."),
+	FConsoleCommandDelegate::CreateStatic(&HandleStopProfileCsvCommand));
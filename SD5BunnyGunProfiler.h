@@ -0,0 +1,93 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+/**
+ * Hot paths of the Bunny Gun gameplay code that are timed by BG_PROFILER_SCOPE.
+ */
+namespace ESD5BunnyGunProfilerScope
+{
+	enum Type
+	{
+		CharacterTick,
+		CalcVelocity,
+		ApplyFriction,
+		ApplyAirAcceleration,
+		DoJump,
+		ApplyTrimpingVelocity,
+		TakeDamage,
+		HandleHit,
+		HandleFallDamage,
+		OnDeath,
+		RagdollCharacter,
+
+		Num
+	};
+}
+
+/**
+ * Records the time spent in each ESD5BunnyGunProfilerScope every frame for a time window & saves it as CSV, so that frame
+ * time can be attributed to this module rather than to engine code. Times are inclusive (CalcVelocity includes
+ * ApplyFriction & ApplyAirAcceleration, DoJump includes ApplyTrimpingVelocity, TakeDamage includes HandleHit etc.), and
+ * the movement scopes run in the movement component tick rather than in CharacterTick.
+ *
+ * Console commands:
+ *   BunnyGun.ProfileCsv <Seconds> [CsvFile]      Records the timings of every frame for Seconds & saves them to CsvFile
+ *                                                (default BunnyGunProfile.csv, relative to the Saved directory).
+ *   BunnyGun.StopProfileCsv                      Stops recording early & saves what was recorded so far.
+ */
+class SD5BUNNYGUN_API FSD5BunnyGunProfiler
+{
+public:
+	// Starts recording for Seconds, saving to Filename when done. Restarts the recording if one is running.
+	static void StartRecording(float Seconds, const FString& Filename);
+
+	// Stops recording & saves the recorded frames. Returns false if nothing was recorded or the file couldn't be written.
+	static bool StopRecording();
+
+	// Returns whether or not frames are being recorded.
+	static FORCEINLINE bool IsRecording()
+	{
+		return bIsRecording;
+	}
+
+	// Adds a call of Scope that took Cycles to the current frame. Safe to call from any thread.
+	static void AddScopeCycles(ESD5BunnyGunProfilerScope::Type Scope, uint32 Cycles);
+
+	// Returns the name of a scope, as used for the CSV columns.
+	static const TCHAR* GetScopeName(ESD5BunnyGunProfilerScope::Type Scope);
+
+private:
+	static bool bIsRecording;
+};
+
+/**
+ * Adds the time it was alive for to a ESD5BunnyGunProfilerScope if FSD5BunnyGunProfiler is recording.
+ */
+class FSD5BunnyGunProfilerScopeTimer
+{
+public:
+	explicit FSD5BunnyGunProfilerScopeTimer(ESD5BunnyGunProfilerScope::Type InScope) :
+	Scope(InScope),
+	bIsRecording(FSD5BunnyGunProfiler::IsRecording()),
+	StartCycles(bIsRecording ? FPlatformTime::Cycles() : 0)
+	{ }
+
+	~FSD5BunnyGunProfilerScopeTimer()
+	{
+		if (bIsRecording)
+		{
+			FSD5BunnyGunProfiler::AddScopeCycles(Scope, FPlatformTime::Cycles() - StartCycles);
+		}
+	}
+
+private:
+	ESD5BunnyGunProfilerScope::Type Scope;
+	bool bIsRecording;
+	uint32 StartCycles;
+};
+
+// Times the rest of the enclosing scope with a cycle stat (for "stat BunnyGunHotPath") & for FSD5BunnyGunProfiler.
+#define BG_PROFILER_SCOPE(Scope, Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	const FSD5BunnyGunProfilerScopeTimer PREPROCESSOR_JOIN(ProfilerScopeTimer_, __LINE__)(ESD5BunnyGunProfilerScope::Scope)
@@ -0,0 +1,205 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#include "SD5BunnyGun.h"
+#include "SD5BunnyGunRagdollBudget.h"
+#include "SD5BunnyGunCharacter.h"
+#include "SD5BunnyGunStats.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ragdolls (Simulating)"), STAT_BunnyGunRagdollsSimulating, STATGROUP_BunnyGun);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ragdolls (Sleeping)"), STAT_BunnyGunRagdollsSleeping, STATGROUP_BunnyGun);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ragdolls (Frozen)"), STAT_BunnyGunRagdollsFrozen, STATGROUP_BunnyGun);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ragdoll Bodies Simulating"), STAT_BunnyGunRagdollBodiesSimulating, STATGROUP_BunnyGun);
+
+static TAutoConsoleVariable<int32> CVarRagdollBodyBudget(
+	TEXT("BunnyGun.RagdollBodyBudget"),
+	160,
+	TEXT("Maximum number of simulating ragdoll bodies per world. Over it, the farthest (or oldest) ragdolls are frozen in their pose.\n")
+	TEXT("-1: no limit"));
+
+static TAutoConsoleVariable<float> CVarRagdollSettleSpeed(
+	TEXT("BunnyGun.RagdollSettleSpeed"),
+	15.0f,
+	TEXT("Speed (cm/s) below which a ragdoll counts as settled."));
+
+static TAutoConsoleVariable<float> CVarRagdollSettleTime(
+	TEXT("BunnyGun.RagdollSettleTime"),
+	0.5f,
+	TEXT("How long (in seconds) a ragdoll has to stay settled before it is put to sleep."));
+
+static TAutoConsoleVariable<float> CVarRagdollLODDistance(
+	TEXT("BunnyGun.RagdollLODDistance"),
+	5000.0f,
+	TEXT("Distance (cm) from the local player above which settled ragdolls are frozen in their pose instead of put to sleep."));
+
+TSD5BunnyGunWorldRegistry<FSD5BunnyGunRagdollBudgetTickFunction> FSD5BunnyGunRagdollBudget::WorldTickFunctions;
+
+FSD5BunnyGunRagdoll::FSD5BunnyGunRagdoll() :
+Character(nullptr),
+State(ESD5BunnyGunRagdollState::Simulating),
+StartTime(0.0f),
+SettledTime(0.0f),
+ViewDistanceSquared(0.0f)
+{ }
+
+FSD5BunnyGunRagdollBudgetTickFunction::FSD5BunnyGunRagdollBudgetTickFunction(UWorld* InWorld) :
+FSD5BunnyGunWorldTickFunction(InWorld, TG_PostPhysics)
+{ }
+
+void FSD5BunnyGunRagdollBudgetTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (TickType == LEVELTICK_ViewportsOnly || TickType == LEVELTICK_PauseTick)
+	{
+		return;
+	}
+
+	const auto SettleSpeed = CVarRagdollSettleSpeed.GetValueOnGameThread();
+	const auto SettleTime = CVarRagdollSettleTime.GetValueOnGameThread();
+	const auto LODDistance = CVarRagdollLODDistance.GetValueOnGameThread();
+	const auto BodyBudget = CVarRagdollBodyBudget.GetValueOnGameThread();
+
+	// Far away ragdolls are the first to go.
+	const auto PlayerController = GEngine->GetFirstLocalPlayerController(World);
+	FVector ViewLocation(ForceInitToZero);
+	FRotator ViewRotation(ForceInitToZero);
+	if (PlayerController != nullptr)
+	{
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	}
+
+	auto NumSimulatingBodies = 0;
+	for (auto& Ragdoll : Ragdolls)
+	{
+		const auto Mesh = Ragdoll.Character->GetMesh();
+		if (Ragdoll.State == ESD5BunnyGunRagdollState::Frozen || Mesh == nullptr)
+		{
+			continue;
+		}
+
+		Ragdoll.ViewDistanceSquared = (PlayerController != nullptr ? FVector::DistSquared(ViewLocation, Mesh->GetComponentLocation()) : 0.0f);
+
+		// Sleeping ragdolls are woken up by whatever hits them.
+		if (Ragdoll.State == ESD5BunnyGunRagdollState::Sleeping && Mesh->RigidBodyIsAwake())
+		{
+			Ragdoll.State = ESD5BunnyGunRagdollState::Simulating;
+			Ragdoll.SettledTime = 0.0f;
+		}
+
+		if (Ragdoll.State != ESD5BunnyGunRagdollState::Simulating)
+		{
+			continue;
+		}
+
+		// NOTE: Only the root body is checked - the limbs come to rest with it.
+		Ragdoll.SettledTime = (Mesh->GetPhysicsLinearVelocity().SizeSquared() < FMath::Square(SettleSpeed) ? Ragdoll.SettledTime + DeltaTime : 0.0f);
+		if (Ragdoll.SettledTime >= SettleTime)
+		{
+			// Nobody will notice a far away ragdoll not waking up again, so freeze it instead.
+			if (PlayerController != nullptr && Ragdoll.ViewDistanceSquared > FMath::Square(LODDistance))
+			{
+				Ragdoll.Character->FreezeRagdoll();
+				Ragdoll.State = ESD5BunnyGunRagdollState::Frozen;
+			}
+			else
+			{
+				Mesh->PutAllRigidBodiesToSleep();
+				Ragdoll.State = ESD5BunnyGunRagdollState::Sleeping;
+			}
+			continue;
+		}
+
+		NumSimulatingBodies += Mesh->Bodies.Num();
+	}
+
+	// Over budget - freeze the farthest ragdolls (or the oldest, as they're all at the same distance without a local player).
+	while (BodyBudget >= 0 && NumSimulatingBodies > BodyBudget)
+	{
+		auto FreezeIndex = INDEX_NONE;
+		for (auto Index = 0; Index < Ragdolls.Num(); ++Index)
+		{
+			const auto& Ragdoll = Ragdolls[Index];
+			if (Ragdoll.State != ESD5BunnyGunRagdollState::Simulating || Ragdoll.Character->GetMesh() == nullptr)
+			{
+				continue;
+			}
+
+			if (FreezeIndex == INDEX_NONE || Ragdoll.ViewDistanceSquared > Ragdolls[FreezeIndex].ViewDistanceSquared ||
+				(Ragdoll.ViewDistanceSquared == Ragdolls[FreezeIndex].ViewDistanceSquared && Ragdoll.StartTime < Ragdolls[FreezeIndex].StartTime))
+			{
+				FreezeIndex = Index;
+			}
+		}
+
+		if (FreezeIndex == INDEX_NONE)
+		{
+			break;
+		}
+
+		auto& Ragdoll = Ragdolls[FreezeIndex];
+		NumSimulatingBodies -= Ragdoll.Character->GetMesh()->Bodies.Num();
+		Ragdoll.Character->FreezeRagdoll();
+		Ragdoll.State = ESD5BunnyGunRagdollState::Frozen;
+	}
+
+	for (const auto& Ragdoll : Ragdolls)
+	{
+		switch (Ragdoll.State)
+		{
+		case ESD5BunnyGunRagdollState::Simulating:
+			INC_DWORD_STAT(STAT_BunnyGunRagdollsSimulating);
+			break;
+
+		case ESD5BunnyGunRagdollState::Sleeping:
+			INC_DWORD_STAT(STAT_BunnyGunRagdollsSleeping);
+			break;
+
+		case ESD5BunnyGunRagdollState::Frozen:
+			INC_DWORD_STAT(STAT_BunnyGunRagdollsFrozen);
+			break;
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_BunnyGunRagdollBodiesSimulating, NumSimulatingBodies);
+}
+
+FString FSD5BunnyGunRagdollBudgetTickFunction::DiagnosticMessage()
+{
+	return FString::Printf(TEXT("FSD5BunnyGunRagdollBudgetTickFunction (%d ragdolls)"), Ragdolls.Num());
+}
+
+void FSD5BunnyGunRagdollBudget::RegisterRagdoll(ASD5BunnyGunCharacter* Character)
+{
+	const auto World = Character->GetWorld();
+	if (World == nullptr || World->PersistentLevel == nullptr)
+	{
+		return;
+	}
+
+	auto& TickFunction = WorldTickFunctions.FindOrAdd(World, World);
+	for (const auto& Ragdoll : TickFunction.Ragdolls)
+	{
+		if (Ragdoll.Character == Character)
+		{
+			return;
+		}
+	}
+
+	FSD5BunnyGunRagdoll Ragdoll;
+	Ragdoll.Character = Character;
+	Ragdoll.StartTime = World->GetTimeSeconds();
+	TickFunction.Ragdolls.Add(Ragdoll);
+}
+
+void FSD5BunnyGunRagdollBudget::UnregisterRagdoll(ASD5BunnyGunCharacter* Character)
+{
+	const auto World = Character->GetWorld();
+	const auto TickFunction = WorldTickFunctions.Find(World);
+	if (TickFunction == nullptr || TickFunction->Ragdolls.RemoveAll([Character](const FSD5BunnyGunRagdoll& Ragdoll) { return Ragdoll.Character == Character; }) <= 0)
+	{
+		return;
+	}
+
+	// Last ragdoll of this world - get rid of the tick function.
+	if (TickFunction->Ragdolls.Num() == 0)
+	{
+		WorldTickFunctions.Remove(World);
+	}
+}
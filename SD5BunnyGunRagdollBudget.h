@@ -0,0 +1,90 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+#include "SD5BunnyGunWorldRegistry.h"
+
+class ASD5BunnyGunCharacter;
+
+/**
+ * What the ragdoll budget has done with a ragdoll.
+ */
+namespace ESD5BunnyGunRagdollState
+{
+	enum Type
+	{
+		// Simulating physics & counting towards the budget.
+		Simulating,
+
+		// Settled & put to sleep. Woken up again by whatever hits it.
+		Sleeping,
+
+		// No longer simulating physics, keeping the pose it had (see ASD5BunnyGunCharacter::FreezeRagdoll()).
+		Frozen
+	};
+}
+
+/**
+ * A ragdoll managed by the ragdoll budget.
+ */
+struct FSD5BunnyGunRagdoll
+{
+	ASD5BunnyGunCharacter* Character;
+	ESD5BunnyGunRagdollState::Type State;
+
+	// The time the character ragdolled.
+	float StartTime;
+
+	// How long (in seconds) the ragdoll has been moving slower than BunnyGun.RagdollSettleSpeed.
+	float SettledTime;
+
+	// Squared distance from the view of the first local player (0 without one).
+	float ViewDistanceSquared;
+
+	FSD5BunnyGunRagdoll();
+};
+
+/**
+ * Tick function that keeps the ragdolls of a world within the budget every frame, after physics has run.
+ */
+struct FSD5BunnyGunRagdollBudgetTickFunction : public FSD5BunnyGunWorldTickFunction
+{
+	// The ragdolls of the world.
+	TArray<FSD5BunnyGunRagdoll> Ragdolls;
+
+	explicit FSD5BunnyGunRagdollBudgetTickFunction(UWorld* InWorld);
+
+	// Puts settled ragdolls to sleep, and freezes ragdolls while there are too many simulating bodies.
+	void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	// Describes this tick function for debugging.
+	FString DiagnosticMessage() override;
+};
+
+/**
+ * Keeps the number of simulating ragdoll bodies in each world within a budget. Ragdolls that have settled are put to
+ * sleep early (far away ones are frozen in their pose instead), and while there are more simulating bodies than the
+ * budget allows, the farthest ragdolls from the local player (or the oldest, without one) are frozen.
+ * Dedicated servers don't simulate ragdolls at all (see ASD5BunnyGunCharacter::OnDeath()).
+ *
+ * "stat BunnyGun" shows the number of simulating, sleeping & frozen ragdolls.
+ *
+ * Console variables:
+ *   BunnyGun.RagdollBodyBudget <Num>        Maximum number of simulating ragdoll bodies per world (-1 for no limit).
+ *   BunnyGun.RagdollSettleSpeed <cm/s>      Speed below which a ragdoll counts as settled.
+ *   BunnyGun.RagdollSettleTime <Seconds>    How long a ragdoll has to stay settled before it is put to sleep.
+ *   BunnyGun.RagdollLODDistance <cm>        Distance above which settled ragdolls are frozen instead of put to sleep.
+ */
+class SD5BUNNYGUN_API FSD5BunnyGunRagdollBudget
+{
+public:
+	// Registers the ragdoll of a character with the budget tick function of its world (creating it if needed).
+	static void RegisterRagdoll(ASD5BunnyGunCharacter* Character);
+
+	// Unregisters the ragdoll of a character (destroying the tick function of its world when it was the last one).
+	static void UnregisterRagdoll(ASD5BunnyGunCharacter* Character);
+
+private:
+	// The budget tick function of each world with at least one registered ragdoll.
+	static TSD5BunnyGunWorldRegistry<FSD5BunnyGunRagdollBudgetTickFunction> WorldTickFunctions;
+};
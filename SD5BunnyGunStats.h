@@ -0,0 +1,12 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+// Stats of the Bunny Gun gameplay code. View them in game with "stat BunnyGun".
+DECLARE_STATS_GROUP(TEXT("BunnyGun"), STATGROUP_BunnyGun, STATCAT_Advanced);
+
+// Hot path timings of the Bunny Gun gameplay code (see FSD5BunnyGunProfiler). View them in game with "stat BunnyGunHotPath".
+DECLARE_STATS_GROUP(TEXT("BunnyGunHotPath"), STATGROUP_BunnyGunHotPath, STATCAT_Advanced);
+
+// Net correction & replay stats of the Bunny Gun movement. View them in game with "stat BunnyGunNet".
+DECLARE_STATS_GROUP(TEXT("BunnyGunNet"), STATGROUP_BunnyGunNet, STATCAT_Advanced);
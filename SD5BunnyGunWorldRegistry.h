@@ -0,0 +1,95 @@
+﻿// Copyright© SD5 - Sean Dewar, 2015.
+
+#pragma once
+
+#include "Engine/EngineBaseTypes.h"
+
+/**
+ * Base of the tick functions that the Bunny Gun systems run once per world. Registers itself with the persistent level of
+ * its world when it is created & unregisters itself when it is destroyed.
+ */
+struct FSD5BunnyGunWorldTickFunction : public FTickFunction
+{
+	// The world the tick function runs in.
+	UWorld* World;
+
+	FSD5BunnyGunWorldTickFunction(UWorld* InWorld, ETickingGroup InTickGroup) :
+	World(InWorld)
+	{
+		TickGroup = InTickGroup;
+		bCanEverTick = true;
+		bTickEvenWhenPaused = false;
+		RegisterTickFunction(World->PersistentLevel);
+	}
+
+	virtual ~FSD5BunnyGunWorldTickFunction()
+	{
+		UnRegisterTickFunction();
+	}
+};
+
+/**
+ * The state that a Bunny Gun system keeps for each world (a tick function, a pool or a cache). Entries are created on first
+ * use, and removed (& destroyed) by the system or when their world is cleaned up.
+ */
+template <typename T>
+class TSD5BunnyGunWorldRegistry
+{
+public:
+	// Called with the entry of a world that is being cleaned up, once it has been removed.
+	typedef void (*FOnWorldCleanup)(T& Entry);
+
+	explicit TSD5BunnyGunWorldRegistry(FOnWorldCleanup InOnWorldCleanup = nullptr) :
+	OnEntryWorldCleanup(InOnWorldCleanup)
+	{ }
+
+	// Returns the entry of a world, or nullptr if it has none.
+	T* Find(UWorld* World) const
+	{
+		const auto Entry = Entries.Find(World);
+		return (Entry != nullptr ? Entry->Get() : nullptr);
+	}
+
+	// Returns the entry of a world, creating it from Args if it has none.
+	template <typename... ArgTypes>
+	T& FindOrAdd(UWorld* World, ArgTypes&&... Args)
+	{
+		auto& Entry = Entries.FindOrAdd(World);
+		if (!Entry.IsValid())
+		{
+			// NOTE: Bound once per registry, for every world.
+			if (!OnWorldCleanupHandle.IsValid())
+			{
+				OnWorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddRaw(this, &TSD5BunnyGunWorldRegistry::OnWorldCleanup);
+			}
+
+			Entry = MakeShareable(new T(Forward<ArgTypes>(Args)...));
+		}
+
+		return *Entry;
+	}
+
+	// Removes the entry of a world, returning it (it is destroyed once the returned pointer is released).
+	TSharedPtr<T> Remove(UWorld* World)
+	{
+		TSharedPtr<T> Entry;
+		Entries.RemoveAndCopyValue(World, Entry);
+		return Entry;
+	}
+
+private:
+	void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+	{
+		const auto Entry = Remove(World);
+		if (Entry.IsValid() && OnEntryWorldCleanup != nullptr)
+		{
+			OnEntryWorldCleanup(*Entry);
+		}
+	}
+
+	// The entry of each world that has one.
+	TMap<UWorld*, TSharedPtr<T>> Entries;
+
+	FOnWorldCleanup OnEntryWorldCleanup;
+	FDelegateHandle OnWorldCleanupHandle;
+};